@@ -0,0 +1,181 @@
+/*
+   Unsupervised correlation learning network using self-organizing maps
+
+        Each sensor projects onto a SOM network which will encode
+        the sensory afferent into neural activity. Depending on the
+        global network connectivity (1, 2, 3, ..., N sensory vars)
+        each SOM connects to other SOMs associated with other sensory
+        variables.
+
+        Simple scenario with 2 variables, representing sensory data.
+
+        Embeddable learner API (libcln).
+*/
+
+#include "model.h"
+#include "cln.h"
+
+/* learner handle */
+struct cln_net{
+	som* soms[2];		// linked soms
+	cln_link* link;		// shared cross-modal weights
+	simopts* params;	// precomputed training schedule
+	double* scratch;	// recall scratch (ns + nd)
+	long epoch_len;		// training steps per epoch
+	long step;		// steps trained in the current epoch
+	int flags;		// handle flags
+};
+
+/* lock every block owned by the handle in memory */
+static int cln_net_lock(cln_net* net)
+{
+	cln_link* l = net->link;
+	simopts* so = net->params;
+	struct{ void* p; size_t n; } blocks[32];
+	int nblocks = 0, ret = 0;
+#define CLN_BLOCK(ptr, size) do{ blocks[nblocks].p = (ptr); blocks[nblocks].n = (size); nblocks++; }while(0)
+	CLN_BLOCK(net, sizeof(cln_net));
+	CLN_BLOCK(net->scratch, (l->ns + l->nd)*sizeof(double));
+	for(int idx = 0; idx < 2; idx++){
+		som* s = net->soms[idx];
+		CLN_BLOCK(s, sizeof(som));
+		CLN_BLOCK(s->neurons, s->xsize*sizeof(neuron*));
+		CLN_BLOCK(s->neurons[0], s->xsize*s->ysize*sizeof(neuron));
+		CLN_BLOCK(s->neurons[0][0].W, s->xsize*s->ysize*s->insize*sizeof(double));
+	}
+	CLN_BLOCK(l, sizeof(cln_link));
+	CLN_BLOCK(l->H, (size_t)l->ns*l->nd*sizeof(double));
+	CLN_BLOCK(l->act, MAX(l->ns, l->nd)*sizeof(double));
+	CLN_BLOCK(l->xact, MAX(l->ns, l->nd)*sizeof(double));
+	CLN_BLOCK(so, sizeof(simopts));
+	CLN_BLOCK(so->alpha, so->simepochs*sizeof(double));
+	CLN_BLOCK(so->sigma, so->simepochs*sizeof(double));
+	CLN_BLOCK(so->gamma, so->simepochs*sizeof(double));
+	CLN_BLOCK(so->xi, so->simepochs*sizeof(double));
+	CLN_BLOCK(so->kappa, so->simepochs*sizeof(double));
+#undef CLN_BLOCK
+	for(int idx = 0; idx < nblocks; idx++)
+		ret |= mlock(blocks[idx].p, blocks[idx].n);
+	return ret;
+}
+
+/* create a learner, NULL if the configuration is invalid or the memory cannot be locked */
+cln_net* cln_net_create(const cln_config* cfg)
+{
+	for(int idx = 0; idx < 2; idx++){
+		if(cfg->xsize[idx] <= 0 || cfg->ysize[idx] <= 0 || cfg->insize[idx] <= 0){
+			printf("cln_net_create: Invalid SOM%d shape.\n", idx + 1);
+			return NULL;
+		}
+	}
+	if(cfg->epochs <= 0 || cfg->epoch_len <= 0){
+		printf("cln_net_create: Invalid training schedule.\n");
+		return NULL;
+	}
+	if(cfg->paramsupdate != CLN_PARAMS_FIXED && cfg->paramsupdate != CLN_PARAMS_ADAPTIVE){
+		printf("cln_net_create: Invalid params update type.\n");
+		return NULL;
+	}
+	if(cfg->learn_rule != CLN_RULE_NONE && cfg->learn_rule != CLN_RULE_HEBBIAN && cfg->learn_rule != CLN_RULE_COVARIANCE){
+		printf("cln_net_create: Invalid cross-modal learning rule.\n");
+		return NULL;
+	}
+	/* the radius decays over epochs/log(sigma0) and the adaptive params over tau */
+	if(!(cfg->sigma0 > 1) || !(cfg->tau > 0)){
+		printf("cln_net_create: Invalid schedule time constants, sigma0 must exceed 1 and tau be positive.\n");
+		return NULL;
+	}
+	cln_net* net = (cln_net*)calloc(1, sizeof(cln_net));
+	for(int idx = 0; idx < 2; idx++)
+		net->soms[idx] = cln_create_som(idx + 1, cfg->xsize[idx], cfg->ysize[idx], cfg->insize[idx], cfg->inmin[idx], cfg->inmax[idx]);
+	net->link = cln_create_link(net->soms[0], net->soms[1]);
+	/* the whole schedule up front, the step path only moves the current epoch */
+	net->params = cln_setup_simulation(cfg->paramsupdate == CLN_PARAMS_FIXED ? FIXED_PARAMS : ADAPTIVE_PARAMS,
+					   cfg->alpha0, cfg->sigma0, cfg->gamma0, cfg->xi0, cfg->kappa0, ARTIFICIAL_DATA, cfg->epochs,
+					   cfg->learn_rule == CLN_RULE_HEBBIAN ? HEBBIAN : cfg->learn_rule == CLN_RULE_COVARIANCE ? COVARIANCE : NONE);
+	for(int idx = 0; idx < cfg->epochs; idx++)
+		cln_schedule_simulation_params(net->params, idx, cfg->alpha0, cfg->sigma0, cfg->gamma0, cfg->xi0, cfg->kappa0, cfg->tau);
+	net->params->cur_epoch = 0;
+	net->soms[0]->params = net->params;
+	net->soms[1]->params = net->params;
+	net->scratch = (double*)calloc(net->link->ns + net->link->nd, sizeof(double));
+	net->epoch_len = cfg->epoch_len;
+	net->flags = cfg->flags;
+	if((net->flags & CLN_REALTIME) && cln_net_lock(net)){
+		printf("cln_net_create: Cannot lock the learner memory, check RLIMIT_MEMLOCK.\n");
+		cln_net_destroy(net);
+		return NULL;
+	}
+	CLN_LOG("cln_net_create: Learner ready, %d epochs of %ld steps%s.\n", cfg->epochs, cfg->epoch_len,
+		net->flags & CLN_REALTIME ? ", memory locked" : "");
+	return net;
+}
+
+/* train on one pair of co-occurring inputs, returns the current epoch */
+int cln_net_train_step(cln_net* net, const double* in1, const double* in2)
+{
+	som* som1 = net->soms[0];
+	som* som2 = net->soms[1];
+	simopts* so = net->params;
+	/* the kernels take mutable inputs but only read them */
+	double* x1 = (double*)in1;
+	double* x2 = (double*)in2;
+	/* sensory elicited activity */
+	cln_compute_sensory_activation(som1, cln_find_sensory_bmu(som1, x1));
+	cln_compute_sensory_activation(som2, cln_find_sensory_bmu(som2, x2));
+	/* cross propagated activity */
+	cln_compute_xmodal_activation(som1, cln_find_xmodal_bmu(som2, som1));
+	cln_compute_xmodal_activation(som2, cln_find_xmodal_bmu(som1, som2));
+	/* total activity */
+	cln_compute_joint_activation(som1);
+	cln_compute_joint_activation(som2);
+	/* sensory and cross-modal plasticity */
+	cln_compute_sensory_weights(som1, x1);
+	cln_compute_sensory_weights(som2, x2);
+	cln_compute_xmodal_weights(som1, som2);
+	/* move along the schedule, staying on the last epoch */
+	if(++net->step == net->epoch_len){
+		net->step = 0;
+		if(so->cur_epoch + 1 < so->simepochs)
+			so->cur_epoch++;
+	}
+	return so->cur_epoch;
+}
+
+/* infer the input of the other som from the input of som from (0 or 1), returns the winner in the other som */
+int cln_net_recall(cln_net* net, int from, const double* in, double* out)
+{
+	som* src = net->soms[from ? 1 : 0];
+	som* dst = net->soms[from ? 0 : 1];
+	return cln_recall(src, dst, (double*)in, out, net->scratch);
+}
+
+/* save the learner weights and training epoch */
+int cln_net_checkpoint(cln_net* net, char* file)
+{
+	return cln_save_model(net->soms[0], net->soms[1], file);
+}
+
+/* resume from a checkpoint of a learner with the same shape at the start of the saved epoch, returns the restored epoch
+   the steps already trained in that epoch are not saved, the learner is unchanged when the checkpoint cannot be read */
+int cln_net_restore(cln_net* net, char* file)
+{
+	int epoch = cln_restore_model(net->soms[0], net->soms[1], file);
+	if(epoch < 0)
+		return -1;
+	net->params->cur_epoch = MIN(epoch, net->params->simepochs - 1);
+	net->step = 0;
+	return net->params->cur_epoch;
+}
+
+/* release a learner */
+void cln_net_destroy(cln_net* net)
+{
+	/* pages stay locked, small blocks may share them with other handles */
+	cln_destroy_link(net->link);
+	cln_destroy_som(net->soms[0]);
+	cln_destroy_som(net->soms[1]);
+	cln_destroy_simulation(net->params);
+	free(net->scratch);
+	free(net);
+}
@@ -0,0 +1,92 @@
+/*
+   Unsupervised correlation learning network using self-organizing maps
+
+        Each sensor projects onto a SOM network which will encode
+        the sensory afferent into neural activity. Depending on the
+        global network connectivity (1, 2, 3, ..., N sensory vars)
+        each SOM connects to other SOMs associated with other sensory
+        variables.
+
+        Simple scenario with 2 variables, representing sensory data.
+
+        Embeddable learner API (libcln).
+
+        A handle owns a pair of linked soms, their training schedule and
+        the recall scratch, so handles are independent and can live in
+        different threads. A single handle must not be used from two
+        threads at once.
+
+        The whole schedule is computed at creation. Training steps and
+        recalls only touch memory owned by the handle: they neither
+        allocate nor print. With CLN_REALTIME all that memory is locked
+        at creation, so the step path also takes no page faults. Creation,
+        checkpoints and destruction may allocate, print and do file I/O,
+        so keep them outside the control loop. cln_set_verbose(0) silences
+        the progress messages.
+
+        The header is self-contained: the handle is opaque and every name
+        it exports carries the cln_ or CLN_ prefix, so it can be included
+        next to the host application headers.
+*/
+
+#ifndef CLN_H
+#define CLN_H
+
+/* handle flags */
+enum{
+	CLN_REALTIME = 1	// lock all handle memory at creation
+};
+
+/* learning params update */
+enum{
+	CLN_PARAMS_FIXED = 0,	// constant learning rates, shrinking neighborhood
+	CLN_PARAMS_ADAPTIVE	// all params follow their time constants
+};
+
+/* cross-modal learning rule */
+enum{
+	CLN_RULE_NONE = 0,	// no cross-modal plasticity
+	CLN_RULE_HEBBIAN,	// Hebbian learning
+	CLN_RULE_COVARIANCE	// covariance learning
+};
+
+/* learner configuration */
+typedef struct{
+	short xsize[2];		// lattice x size of each som
+	short ysize[2];		// lattice y size of each som
+	short insize[2];	// input vector size of each som
+	double inmin[2];	// lower bound of each som input domain
+	double inmax[2];	// upper bound of each som input domain
+	short paramsupdate;	// CLN_PARAMS_FIXED or CLN_PARAMS_ADAPTIVE
+	short learn_rule;	// cross-modal learning rule, CLN_RULE_*
+	double alpha0;		// sensory projections learning rate init
+	double sigma0;		// neighborhood radius init, above 1
+	double gamma0;		// cross-modal impact factor init
+	double xi0;		// inhibitory component factor init
+	double kappa0;		// cross-modal Hebbian learning rate init
+	double tau;		// time constant of the adaptive params, positive
+	int epochs;		// epochs in the schedule, training stays on the last one
+	long epoch_len;		// training steps per epoch
+	int flags;		// handle flags
+}cln_config;
+
+/* learner handle */
+typedef struct cln_net cln_net;
+
+/* create a learner, NULL if the configuration is invalid or the memory cannot be locked */
+cln_net* cln_net_create(const cln_config* cfg);
+/* train on one pair of co-occurring inputs, returns the current epoch */
+int cln_net_train_step(cln_net* net, const double* in1, const double* in2);
+/* infer the input of the other som from the input of som from (0 or 1), returns the winner in the other som */
+int cln_net_recall(cln_net* net, int from, const double* in, double* out);
+/* save the learner weights and training epoch */
+int cln_net_checkpoint(cln_net* net, char* file);
+/* resume from a checkpoint of a learner with the same shape at the start of the saved epoch, returns the restored epoch
+   the steps already trained in that epoch are not saved, the learner is unchanged when the checkpoint cannot be read */
+int cln_net_restore(cln_net* net, char* file);
+/* release a learner */
+void cln_net_destroy(cln_net* net);
+/* turn the progress messages on or off */
+void cln_set_verbose(int on);
+
+#endif
@@ -20,7 +20,7 @@ indataset* cln_create_input_dataset(short netid, short data_src, int vsize, int
 	/* init */
 	FILE *fin, *fout; 
 	int lcnt = 0, lidx = 1, c;
-	printf("cln_create_input_dataset: Creating input dataset...\n");
+	CLN_LOG("cln_create_input_dataset: Creating input dataset...\n");
         /* build the dataset */
 	indataset* dset = (indataset*)calloc(1, sizeof(indataset));
 	dset->size = vsize;
@@ -50,40 +50,40 @@ indataset* cln_create_input_dataset(short netid, short data_src, int vsize, int
 			*/					
 		break;
 		case SENSOR_DATA:
-      			printf("cln_create_input_dataset: Reading sensor data from file...\n");
+      			CLN_LOG("cln_create_input_dataset: Reading sensor data from file...\n");
 			/* access the raw data file */  
 			fin = fopen(data_file, "r");
 		        while((c=fgetc(fin))!=EOF) if(c=='\n') lcnt++;
-			printf("cln_create_input_dataset: Read %d sensory data samples.\n", lcnt);
+			CLN_LOG("cln_create_input_dataset: Read %d sensory data samples.\n", lcnt);
 	        	for(int idx = 0; idx<dset->len; idx++){
                 		for(int jdx = 0; jdx < dset->size; jdx++){
 		                        dset->data[idx][jdx] = 1;
                 		}
         		}
-			printf("cln_create_input_dataset: Closing sensory data file.\n");
+			CLN_LOG("cln_create_input_dataset: Closing sensory data file.\n");
 			fclose(fin);		
 		break;
 	}
-	printf("cln_create_input_dataset: Created %s data input dataset.\n", data_src==ARTIFICIAL_DATA ? "artificial" : "sensory");
+	CLN_LOG("cln_create_input_dataset: Created %s data input dataset.\n", data_src==ARTIFICIAL_DATA ? "artificial" : "sensory");
 	return dset;
 }
 
 /* create the output dataset struct */
 outdataset* cln_create_output_dataset(simopts* so, indataset* ind, som* net)
 {
-	printf("cln_create_output_dataset: Creating output dataset for som %d ...\n", net->id);
+	CLN_LOG("cln_create_output_dataset: Creating output dataset for som %d ...\n", net->id);
 	outdataset* outd = (outdataset*)calloc(1, sizeof(outdataset));
 	outd->sopts = so;
 	outd->idata = ind;
 	outd->somnet = net;
-	printf("cln_create_output_dataset: Created som %d output dataset.\n", net->id);	
+	CLN_LOG("cln_create_output_dataset: Created som %d output dataset.\n", net->id);	
 	return outd;
 }
 
 /* dump the runtime data in a file for later processing */
 char* cln_dump_output_dataset(outdataset* ods)
 {	
-	printf("cln_dump_output_dataset: Dumping output dataset to disk...\n");
+	CLN_LOG("cln_dump_output_dataset: Dumping output dataset to disk...\n");
 	time_t rawt; time(&rawt);
 	struct tm* tinfo = localtime(&rawt);
 	FILE* fout; 
@@ -104,7 +104,7 @@ char* cln_dump_output_dataset(outdataset* ods)
 		return NULL;
 	}
 	fwrite(ods, sizeof(outdataset), 1, fout);
-	printf("cln_dump_output_dataset: Dumped to disk: %s\n", nfout);
+	CLN_LOG("cln_dump_output_dataset: Dumped to disk: %s\n", nfout);
 	fclose(fout);
 	return nfout;
 }
@@ -112,13 +112,13 @@ char* cln_dump_output_dataset(outdataset* ods)
 /* read output dataset for debugging purposes */
 int cln_read_output_dataset(char *dumped_file)
 {	
-	printf("cln_read_output_dataset: Reading the dumped output dataset - debug ...\n");
+	CLN_LOG("cln_read_output_dataset: Reading the dumped output dataset - debug ...\n");
 	char* debug_file = (char*)calloc(strlen(dumped_file)+9, sizeof(char));
 	debug_file = strcat(debug_file, dumped_file); 
 	debug_file = strcat(debug_file, "-DEBUG");
 	FILE* fin = fopen(dumped_file, "rb");
 	FILE* fout = fopen(debug_file, "w");
-	printf("cln_read_output_dataset: Debug file is %s \n", debug_file);
+	CLN_LOG("cln_read_output_dataset: Debug file is %s \n", debug_file);
 	outdataset* od = (outdataset*)calloc(1, sizeof(outdataset));
 	if(!fin){
 		printf("cln_read_output_dataset: Cannot open runtime data file !\n");
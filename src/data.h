@@ -12,6 +12,9 @@
         Data input readout and preprocessing utils.
 */
 
+#ifndef CLN_DATA_H
+#define CLN_DATA_H
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -45,3 +48,5 @@ outdataset* cln_create_output_dataset(simopts* so, indataset* ind, som* net);
 char* cln_dump_output_dataset(outdataset* o);
 /* read output dataset for debugging purposes */
 int cln_read_output_dataset(char* ifile);
+
+#endif
@@ -0,0 +1,125 @@
+/*
+   Unsupervised correlation learning network using self-organizing maps
+
+        Each sensor projects onto a SOM network which will encode
+        the sensory afferent into neural activity. Depending on the
+        global network connectivity (1, 2, 3, ..., N sensory vars)
+        each SOM connects to other SOMs associated with other sensory
+        variables.
+
+        Simple scenario with 2 variables, representing sensory data.
+
+        Compute kernels specialized at compile time for fixed lattice shapes.
+        Each registered shape gets its own copy of the kernels with constant
+        loop bounds, the lattice and the sensory weights are walked as the
+        flat blocks allocated by cln_create_som.
+*/
+
+#include "kernels.h"
+
+/* squared lattice distance, same metric as cln_compute_norm */
+#define CLN_LATTICE_DIST2(x0, y0, x1, y1) \
+	(((double)(x0) + (x1))*((double)(x0) + (x1)) + ((double)(y0) + (y1))*((double)(y0) + (y1)))
+
+/* kernels template for a XS x YS lattice with IS sized inputs */
+#define CLN_DEFINE_KERNELS(XS, YS, IS) \
+static neuron* cln_sensory_bmu_##XS##x##YS##x##IS(som* s, double* vin) \
+{ \
+	const neuron* n = s->neurons[0]; \
+	const double* W = n[0].W; \
+	double min_qe = DBL_MAX, second_qe = DBL_MAX; \
+	int win = 0, second = 0; \
+	for(int idx = 0; idx < XS*YS; idx++){ \
+		double qe = 0.0f; \
+		_Pragma("GCC unroll 16") \
+		for(int widx = 0; widx < IS; widx++) \
+			qe += (vin[widx] + W[idx*IS + widx])*(vin[widx] + W[idx*IS + widx]); \
+		if(qe < min_qe){ \
+			second_qe = min_qe; \
+			second = win; \
+			min_qe = qe; \
+			win = idx; \
+		} \
+		else if(qe < second_qe){ \
+			second_qe = qe; \
+			second = idx; \
+		} \
+	} \
+	s->metrics.qe += sqrt(min_qe); \
+	s->metrics.te += abs(win/YS - second/YS) > 1 || abs(win%YS - second%YS) > 1; \
+	s->metrics.nsamples++; \
+	return &s->neurons[win/YS][win%YS]; \
+} \
+static void cln_sensory_activation_##XS##x##YS##x##IS(som* s, neuron* bmu) \
+{ \
+	neuron* n = s->neurons[0]; \
+	const double sigma = s->params->sigma[s->params->cur_epoch]; \
+	const double inv = 1.0/(2*sigma*sigma); \
+	for(int idx = 0; idx < XS; idx++){ \
+		_Pragma("GCC unroll 32") \
+		for(int jdx = 0; jdx < YS; jdx++) \
+			n[idx*YS + jdx].As = exp(-CLN_LATTICE_DIST2(bmu->xpos, bmu->ypos, idx, jdx)*inv); \
+	} \
+} \
+static void cln_xmodal_activation_##XS##x##YS##x##IS(som* s, neuron* bmu) \
+{ \
+	neuron* n = s->neurons[0]; \
+	const double sigma = s->params->sigma[s->params->cur_epoch]; \
+	const double inv = 1.0/(2*sigma*sigma); \
+	for(int idx = 0; idx < XS; idx++){ \
+		_Pragma("GCC unroll 32") \
+		for(int jdx = 0; jdx < YS; jdx++) \
+			n[idx*YS + jdx].Ax = exp(-CLN_LATTICE_DIST2(bmu->xpos, bmu->ypos, idx, jdx)*inv); \
+	} \
+} \
+static void cln_joint_activation_##XS##x##YS##x##IS(som* s) \
+{ \
+	neuron* n = s->neurons[0]; \
+	const double gamma = s->params->gamma[s->params->cur_epoch]; \
+	_Pragma("GCC unroll 32") \
+	for(int idx = 0; idx < XS*YS; idx++) \
+		n[idx].At = (1.0 - gamma)*n[idx].As + gamma*n[idx].Ax; \
+} \
+static void cln_sensory_weights_##XS##x##YS##x##IS(som* s, double* inp) \
+{ \
+	const neuron* n = s->neurons[0]; \
+	double* W = n[0].W; \
+	const double alpha = s->params->alpha[s->params->cur_epoch]; \
+	const double xi = s->params->xi[s->params->cur_epoch]; \
+	for(int idx = 0; idx < XS*YS; idx++){ \
+		const double rate = alpha*n[idx].At - xi*(n[idx].As - n[idx].At); \
+		_Pragma("GCC unroll 16") \
+		for(int widx = 0; widx < IS; widx++) \
+			W[idx*IS + widx] += rate*(inp[widx] - W[idx*IS + widx]); \
+	} \
+} \
+static const cln_kernels cln_kernels_##XS##x##YS##x##IS = { \
+	XS, YS, IS, \
+	cln_sensory_bmu_##XS##x##YS##x##IS, \
+	cln_sensory_activation_##XS##x##YS##x##IS, \
+	cln_xmodal_activation_##XS##x##YS##x##IS, \
+	cln_joint_activation_##XS##x##YS##x##IS, \
+	cln_sensory_weights_##XS##x##YS##x##IS \
+};
+
+#define CLN_KERNELS_ENTRY(XS, YS, IS) &cln_kernels_##XS##x##YS##x##IS,
+
+/* instantiate the kernels for all registered shapes */
+CLN_KERNEL_SHAPES(CLN_DEFINE_KERNELS)
+
+/* registered kernels */
+static const cln_kernels* const cln_kernels_registry[] = {
+	CLN_KERNEL_SHAPES(CLN_KERNELS_ENTRY)
+};
+
+/* select the kernels specialized for a lattice shape, falls back to the generic ones */
+const cln_kernels* cln_select_kernels(short xsize, short ysize, short insize)
+{
+	for(size_t idx = 0; idx < sizeof(cln_kernels_registry)/sizeof(cln_kernels_registry[0]); idx++){
+		if(cln_kernels_registry[idx]->xsize == xsize &&
+		   cln_kernels_registry[idx]->ysize == ysize &&
+		   cln_kernels_registry[idx]->insize == insize)
+			return cln_kernels_registry[idx];
+	}
+	return &cln_generic_kernels;
+}
@@ -0,0 +1,44 @@
+/*
+   Unsupervised correlation learning network using self-organizing maps
+
+        Each sensor projects onto a SOM network which will encode
+        the sensory afferent into neural activity. Depending on the
+        global network connectivity (1, 2, 3, ..., N sensory vars)
+        each SOM connects to other SOMs associated with other sensory
+        variables.
+
+        Simple scenario with 2 variables, representing sensory data.
+
+        Compute kernels specialized at compile time for fixed lattice shapes.
+*/
+
+#ifndef CLN_KERNELS_H
+#define CLN_KERNELS_H
+
+#include "som.h"
+
+/* registered lattice shapes K(xsize, ysize, insize) - add deployed shapes here */
+#define CLN_KERNEL_SHAPES(K) \
+	K(10, 10, 2) \
+	K(20, 20, 2) \
+	K(30, 30, 2)
+
+/* SOM compute kernels */
+typedef struct cln_kernels{
+	short xsize;	// lattice x size the kernels are built for (0 for any)
+	short ysize;	// lattice y size the kernels are built for (0 for any)
+	short insize;	// input vector size the kernels are built for (0 for any)
+	neuron* (*sensory_bmu)(som* s, double* vin);		// sensory winner search
+	void (*sensory_activation)(som* s, neuron* bmu);	// sensory elicited activation
+	void (*xmodal_activation)(som* s, neuron* bmu);		// cross-modal elicited activation
+	void (*joint_activation)(som* s);			// total activation
+	void (*sensory_weights)(som* s, double* inp);		// sensory projections update
+}cln_kernels;
+
+/* runtime bound kernels, valid for any lattice shape */
+extern const cln_kernels cln_generic_kernels;
+
+/* select the kernels specialized for a lattice shape, falls back to the generic ones */
+const cln_kernels* cln_select_kernels(short xsize, short ysize, short insize);
+
+#endif
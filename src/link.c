@@ -0,0 +1,380 @@
+/*
+   Unsupervised correlation learning network using self-organizing maps
+
+        Each sensor projects onto a SOM network which will encode
+        the sensory afferent into neural activity. Depending on the
+        global network connectivity (1, 2, 3, ..., N sensory vars)
+        each SOM connects to other SOMs associated with other sensory
+        variables.
+
+        Simple scenario with 2 variables, representing sensory data.
+
+        Cross-modal link between two soms.
+*/
+
+#include "link.h"
+
+/* largest activity in v[from..to) */
+static double cln_block_max(const double* v, int from, int to)
+{
+	double m = 0.0f;
+	for(int idx = from; idx < to; idx++)
+		m = v[idx] > m ? v[idx] : m;
+	return m;
+}
+
+/* hint the kernel to page in rows [from, to) of a mapped link */
+static void cln_prefetch_rows(const cln_link* l, int from, int to)
+{
+	if(!l->mapped || from >= to)
+		return;
+	long page = sysconf(_SC_PAGESIZE);
+	uintptr_t beg = (uintptr_t)&l->H[(size_t)from*l->nd] & ~(uintptr_t)(page - 1);
+	uintptr_t end = (uintptr_t)&l->H[(size_t)to*l->nd];
+	madvise((void*)beg, end - beg, MADV_WILLNEED);
+}
+
+/* create the link between two soms with small random weights and attach it to both */
+cln_link* cln_create_link(som* s, som* d)
+{
+	cln_link* l = (cln_link*)calloc(1, sizeof(cln_link));
+	l->s = s;
+	l->d = d;
+	l->ns = s->xsize*s->ysize;
+	l->nd = d->xsize*d->ysize;
+	l->H = (double*)calloc((size_t)l->ns*l->nd, sizeof(double));
+	l->act = (double*)calloc(l->ns > l->nd ? l->ns : l->nd, sizeof(double));
+	l->xact = (double*)calloc(l->ns > l->nd ? l->ns : l->nd, sizeof(double));
+	for(size_t idx = 0; idx < (size_t)l->ns*l->nd; idx++){
+		/* randomly init cross-modal weights with small numbers */
+		l->H[idx] = (double)rand()/(double)RAND_MAX;
+	}
+	getrusage(RUSAGE_SELF, &l->ru0);
+	s->link = l;
+	d->link = l;
+	CLN_LOG("cln_create_link: Linked SOM%d and SOM%d with %dx%d shared cross-modal weights.\n", s->id, d->id, l->ns, l->nd);
+	return l;
+}
+
+/* map the weights file of a link, a new file is created empty, an existing one must hold ns x nd weights */
+static cln_link* cln_map_link(som* s, som* d, char* file, double act_eps, int create)
+{
+	const char* who = create ? "cln_create_mapped_link" : "cln_open_mapped_link";
+	size_t ns = s->xsize*s->ysize, nd = d->xsize*d->ysize;
+	size_t size = ns*nd*sizeof(double);
+	struct stat st;
+	int fd = open(file, create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0644);
+	if(fd < 0){
+		printf("%s: Cannot open cross-modal weights file %s.\n", who, file);
+		return NULL;
+	}
+	/* sparse file, the weights start at zero and only touched tiles get pages */
+	if(create && ftruncate(fd, size) < 0){
+		printf("%s: Cannot size cross-modal weights file %s.\n", who, file);
+		close(fd);
+		return NULL;
+	}
+	if(!create && (fstat(fd, &st) < 0 || (size_t)st.st_size != size)){
+		printf("%s: %s does not hold %zux%zu cross-modal weights.\n", who, file, ns, nd);
+		close(fd);
+		return NULL;
+	}
+	double* H = (double*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(H == MAP_FAILED){
+		printf("%s: Cannot map cross-modal weights file %s.\n", who, file);
+		return NULL;
+	}
+	/* tiles are fetched explicitly, no blind readahead */
+	madvise(H, size, MADV_RANDOM);
+	cln_link* l = (cln_link*)calloc(1, sizeof(cln_link));
+	l->s = s;
+	l->d = d;
+	l->ns = ns;
+	l->nd = nd;
+	l->H = H;
+	l->act = (double*)calloc(ns > nd ? ns : nd, sizeof(double));
+	l->xact = (double*)calloc(ns > nd ? ns : nd, sizeof(double));
+	l->act_eps = act_eps;
+	l->mapped = 1;
+	l->file = strdup(file);
+	getrusage(RUSAGE_SELF, &l->ru0);
+	s->link = l;
+	d->link = l;
+	CLN_LOG("%s: Linked SOM%d and SOM%d with %zux%zu cross-modal weights mapped from %s (%.1lf MB).\n",
+		who, s->id, d->id, ns, nd, file, size/1048576.0);
+	return l;
+}
+
+/* create a link keeping the weights in a file backed mapping, skipping tiles below act_eps */
+cln_link* cln_create_mapped_link(som* s, som* d, char* file, double act_eps)
+{
+	return cln_map_link(s, d, file, act_eps, 1);
+}
+
+/* map the weights file of a previous run, skipping tiles below act_eps */
+cln_link* cln_open_mapped_link(som* s, som* d, char* file, double act_eps)
+{
+	return cln_map_link(s, d, file, act_eps, 0);
+}
+
+/* write the dirty weights of a mapped link back to its file */
+int cln_sync_link(cln_link* l)
+{
+	if(l->mapped && msync(l->H, (size_t)l->ns*l->nd*sizeof(double), MS_SYNC) < 0){
+		printf("cln_sync_link: Cannot write back cross-modal weights file %s.\n", l->file);
+		return -1;
+	}
+	return EXIT_SUCCESS;
+}
+
+/* report tiles and page faults counters */
+void cln_report_link(cln_link* l)
+{
+	struct rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+	printf("cln_report_link: SOM%d-SOM%d tiles processed %ld skipped %ld\n", l->s->id, l->d->id, l->touched, l->skipped);
+	printf("cln_report_link: page faults minor %ld major %ld, blocks in %ld out %ld\n",
+	       ru.ru_minflt - l->ru0.ru_minflt, ru.ru_majflt - l->ru0.ru_majflt,
+	       ru.ru_inblock - l->ru0.ru_inblock, ru.ru_oublock - l->ru0.ru_oublock);
+}
+
+/* detach and release a link */
+void cln_destroy_link(cln_link* l)
+{
+	l->s->link = NULL;
+	l->d->link = NULL;
+	if(l->mapped)
+		munmap(l->H, (size_t)l->ns*l->nd*sizeof(double));
+	else
+		free(l->H);
+	free(l->file);
+	free(l->act);
+	free(l->xact);
+	free(l);
+}
+
+/* check whether any som in the list has its cross-modal weights in a mapped file */
+int cln_any_mapped_link(som** soms, int nsoms)
+{
+	for(int idx = 0; idx < nsoms; idx++)
+		if(soms[idx]->link && soms[idx]->link->mapped)
+			return 1;
+	return 0;
+}
+
+/* som is part of the list */
+static int cln_som_listed(som** soms, int nsoms, const som* s)
+{
+	for(int idx = 0; idx < nsoms; idx++)
+		if(soms[idx] == s)
+			return 1;
+	return 0;
+}
+
+/* gather the distinct links joining soms of the list, returns their number */
+int cln_collect_links(som** soms, int nsoms, cln_link** links, int max)
+{
+	int nlinks = 0;
+	for(int idx = 0; idx < nsoms; idx++){
+		cln_link* l = soms[idx]->link;
+		/* each link is reached from both its soms, keep it once */
+		if(!l || l->s != soms[idx] || !cln_som_listed(soms, nsoms, l->d))
+			continue;
+		if(nlinks < max)
+			links[nlinks++] = l;
+	}
+	return nlinks;
+}
+
+/* weight between neuron h of from and neuron i of the other som */
+double cln_link_weight(const cln_link* l, const som* from, int h, int i)
+{
+	return from == l->s ? l->H[(size_t)h*l->nd + i] : l->H[(size_t)i*l->nd + h];
+}
+
+/* forward projection over the active row tiles, counts the tiles processed and skipped in tiles */
+static void cln_forward_tiles(const cln_link* l, const double* act, double* out, long* tiles)
+{
+	const int ncb = (l->nd + CLN_TILE_COLS - 1)/CLN_TILE_COLS;
+	long touched = 0, skipped = 0;
+	memset(out, 0, l->nd*sizeof(double));
+	for(int rb = 0; rb < l->ns; rb += CLN_TILE_ROWS){
+		int re = MIN(rb + CLN_TILE_ROWS, l->ns);
+		/* rows without activity contribute nothing */
+		if(l->act_eps > 0 && cln_block_max(act, rb, re) < l->act_eps){
+			skipped += ncb;
+			continue;
+		}
+		cln_prefetch_rows(l, re, MIN(re + CLN_TILE_ROWS, l->ns));
+		for(int hdx = rb; hdx < re; hdx++){
+			const double* row = &l->H[(size_t)hdx*l->nd];
+			const double a = act[hdx];
+			for(int idx = 0; idx < l->nd; idx++)
+				out[idx] += a*row[idx];
+		}
+		touched += ncb;
+	}
+	tiles[0] = touched;
+	tiles[1] = skipped;
+}
+
+/* transposed projection over the active column tiles, counts the tiles processed and skipped in tiles */
+static void cln_transposed_tiles(const cln_link* l, const double* act, double* out, long* tiles)
+{
+	const int ncb = (l->nd + CLN_TILE_COLS - 1)/CLN_TILE_COLS;
+	char active[ncb];
+	int nactive = 0;
+	/* columns without activity contribute nothing */
+	for(int cb = 0; cb < ncb; cb++){
+		active[cb] = l->act_eps <= 0 || cln_block_max(act, cb*CLN_TILE_COLS, MIN((cb + 1)*CLN_TILE_COLS, l->nd)) >= l->act_eps;
+		nactive += active[cb];
+	}
+	for(int hdx = 0; hdx < l->ns; hdx++){
+		const double* row = &l->H[(size_t)hdx*l->nd];
+		double sum = 0.0f;
+		for(int cb = 0; cb < ncb; cb++){
+			if(!active[cb])
+				continue;
+			int ce = MIN((cb + 1)*CLN_TILE_COLS, l->nd);
+			for(int idx = cb*CLN_TILE_COLS; idx < ce; idx++)
+				sum += row[idx]*act[idx];
+		}
+		out[hdx] = sum;
+	}
+	long nrb = (l->ns + CLN_TILE_ROWS - 1)/CLN_TILE_ROWS;
+	tiles[0] = nrb*nactive;
+	tiles[1] = nrb*(ncb - nactive);
+}
+
+/* project the activity of the s som onto the d som: out[i] = sum_h act[h]*H[h][i] */
+void cln_link_forward(cln_link* l, const double* act, double* out)
+{
+	long tiles[2];
+	cln_forward_tiles(l, act, out, tiles);
+	l->touched += tiles[0];
+	l->skipped += tiles[1];
+}
+
+/* project the activity of the d som onto the s som: out[h] = sum_i H[h][i]*act[i] */
+void cln_link_transposed(cln_link* l, const double* act, double* out)
+{
+	long tiles[2];
+	cln_transposed_tiles(l, act, out, tiles);
+	l->touched += tiles[0];
+	l->skipped += tiles[1];
+}
+
+/* project the activity of from onto the other som through the matching view */
+void cln_link_project(cln_link* l, const som* from, const double* act, double* out)
+{
+	if(from == l->s)
+		cln_link_forward(l, act, out);
+	else
+		cln_link_transposed(l, act, out);
+}
+
+/* same projection without counting tiles, the link is only read so any number of threads can recall through it */
+void cln_link_recall(const cln_link* l, const som* from, const double* act, double* out)
+{
+	long tiles[2];
+	if(from == l->s)
+		cln_forward_tiles(l, act, out, tiles);
+	else
+		cln_transposed_tiles(l, act, out, tiles);
+}
+
+/* adapt the shared weights from the total activity of both soms and normalize them */
+void cln_update_link(cln_link* l, simopts* so)
+{
+	const neuron* ns = l->s->neurons[0];
+	const neuron* nd = l->d->neurons[0];
+	const double kappa = so->kappa[so->cur_epoch];
+	const int ncb = (l->nd + CLN_TILE_COLS - 1)/CLN_TILE_COLS;
+	double* Ats = l->act;
+	double* Atd = l->xact;
+	double cmax[ncb];
+	double meanAts = 0.0f, meanAtd = 0.0f;
+	double minH = DBL_MAX, maxH = -DBL_MAX;
+	/* moments of the old and new (raw) weights to measure the change without an extra pass */
+	double sumO = 0.0f, sumOO = 0.0f, sumR = 0.0f, sumRR = 0.0f, sumRO = 0.0f;
+	long nH = 0, touched = 0;
+	/* stage the total activity of both soms */
+	for(int hdx = 0; hdx < l->ns; hdx++)
+		Ats[hdx] = ns[hdx].At;
+	for(int idx = 0; idx < l->nd; idx++)
+		Atd[idx] = nd[idx].At;
+	for(int cb = 0; cb < ncb; cb++)
+		cmax[cb] = cln_block_max(Atd, cb*CLN_TILE_COLS, MIN((cb + 1)*CLN_TILE_COLS, l->nd));
+	if(so->learn_rule == COVARIANCE){
+		/* mean activation at the source and destination map */
+		for(int hdx = 0; hdx < l->ns; hdx++)
+			meanAts += Ats[hdx];
+		for(int idx = 0; idx < l->nd; idx++)
+			meanAtd += Atd[idx];
+		meanAts /= l->ns;
+		meanAtd /= l->nd;
+	}
+	/* new raw weights in the co-active tiles, tracking their range for the normalization */
+	for(int rb = 0; rb < l->ns; rb += CLN_TILE_ROWS){
+		int re = MIN(rb + CLN_TILE_ROWS, l->ns);
+		double rmax = cln_block_max(Ats, rb, re);
+		cln_prefetch_rows(l, re, MIN(re + CLN_TILE_ROWS, l->ns));
+		for(int cb = 0; cb < ncb; cb++)
+			touched += l->act_eps <= 0 || rmax*cmax[cb] >= l->act_eps;
+		for(int hdx = rb; hdx < re; hdx++){
+			double* row = &l->H[(size_t)hdx*l->nd];
+			for(int cb = 0; cb < ncb; cb++){
+				if(l->act_eps > 0 && rmax*cmax[cb] < l->act_eps)
+					continue;
+				int ce = MIN((cb + 1)*CLN_TILE_COLS, l->nd);
+				for(int idx = cb*CLN_TILE_COLS; idx < ce; idx++){
+					double old = row[idx], raw = 0.0f;
+					switch(so->learn_rule){
+						case(NONE):
+							raw = 0.0f;
+						break;
+						case(HEBBIAN):
+							raw = kappa*Ats[hdx]*Atd[idx];
+						break;
+						case(COVARIANCE):
+							raw = kappa*(Ats[hdx] - meanAts)*(Atd[idx] - meanAtd);
+						break;
+					}
+					row[idx] = raw;
+					minH = raw < minH ? raw : minH;
+					maxH = raw > maxH ? raw : maxH;
+					sumO += old; sumOO += old*old;
+					sumR += raw; sumRR += raw*raw; sumRO += raw*old;
+				}
+				nH += ce - cb*CLN_TILE_COLS;
+			}
+		}
+	}
+	/* apply normalization to the updated tiles */
+	const double rng = maxH - minH;
+	for(int rb = 0; rb < l->ns; rb += CLN_TILE_ROWS){
+		int re = MIN(rb + CLN_TILE_ROWS, l->ns);
+		double rmax = cln_block_max(Ats, rb, re);
+		for(int hdx = rb; hdx < re; hdx++){
+			double* row = &l->H[(size_t)hdx*l->nd];
+			for(int cb = 0; cb < ncb; cb++){
+				if(l->act_eps > 0 && rmax*cmax[cb] < l->act_eps)
+					continue;
+				int ce = MIN((cb + 1)*CLN_TILE_COLS, l->nd);
+				for(int idx = cb*CLN_TILE_COLS; idx < ce; idx++)
+					row[idx] = (row[idx] - minH)/rng;
+			}
+		}
+	}
+	l->touched += 2*touched;
+	l->skipped += 2*((long)ncb*((l->ns + CLN_TILE_ROWS - 1)/CLN_TILE_ROWS) - touched);
+	if(!nH)
+		return;
+	/* mean squared change of the normalized weights, seen identically from both soms */
+	double dh = ((sumRR - 2*minH*sumR + nH*minH*minH)/(rng*rng) - 2*(sumRO - minH*sumO)/rng + sumOO)/nH;
+	l->s->metrics.dh += dh;
+	l->d->metrics.dh += dh;
+	l->s->metrics.nupdates++;
+	l->d->metrics.nupdates++;
+}
@@ -0,0 +1,87 @@
+/*
+   Unsupervised correlation learning network using self-organizing maps
+
+        Each sensor projects onto a SOM network which will encode
+        the sensory afferent into neural activity. Depending on the
+        global network connectivity (1, 2, 3, ..., N sensory vars)
+        each SOM connects to other SOMs associated with other sensory
+        variables.
+
+        Simple scenario with 2 variables, representing sensory data.
+
+        Cross-modal link between two soms.
+
+        The Hebbian and covariance rules produce the same weight for the
+        pair (s neuron h, d neuron i) seen from either som, so the link
+        stores the matrix once, row major with s neurons as rows. The s
+        som uses it as is (forward view) and the d som uses its transpose.
+
+        The matrix is processed in tiles of CLN_TILE_ROWS x CLN_TILE_COLS.
+        With an activity threshold set, tiles whose rows or columns carry
+        no activity above it are skipped, so only the part of the matrix
+        near the current winners is touched. Large lattices keep the
+        matrix in a file backed mapping and only those tiles are paged in.
+        Skipped tiles keep their previous weights in the update, which is
+        exact for a zero threshold.
+*/
+
+#ifndef CLN_LINK_H
+#define CLN_LINK_H
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include "data.h"
+
+#define CLN_TILE_ROWS	64	// tile height (source neurons)
+#define CLN_TILE_COLS	512	// tile width (destination neurons), one page of doubles
+
+/* cross-modal link */
+typedef struct cln_link{
+	som* s;		// som on the rows (forward view)
+	som* d;		// som on the columns (transposed view)
+	int ns;		// number of neurons in s
+	int nd;		// number of neurons in d
+	double* H;	// shared cross-modal weights (ns x nd)
+	double* act;	// activation staging buffer (max(ns, nd))
+	double* xact;	// cross-modal activation buffer (max(ns, nd))
+	double act_eps;	// activity below which tiles are skipped (0 processes all tiles)
+	int mapped;	// weights live in a file backed mapping
+	char* file;	// weights file of a mapped link
+	long touched;	// tiles processed by training
+	long skipped;	// tiles skipped for lack of activity by training
+	struct rusage ru0;	// resource usage when the link was created
+}cln_link;
+
+/* create the link between two soms with small random weights and attach it to both */
+cln_link* cln_create_link(som* s, som* d);
+/* create a link keeping the weights in a file backed mapping, skipping tiles below act_eps */
+cln_link* cln_create_mapped_link(som* s, som* d, char* file, double act_eps);
+/* map the weights file of a previous run, skipping tiles below act_eps */
+cln_link* cln_open_mapped_link(som* s, som* d, char* file, double act_eps);
+/* write the dirty weights of a mapped link back to its file */
+int cln_sync_link(cln_link* l);
+/* check whether any som in the list has its cross-modal weights in a mapped file */
+int cln_any_mapped_link(som** soms, int nsoms);
+/* report tiles and page faults counters */
+void cln_report_link(cln_link* l);
+/* detach and release a link */
+void cln_destroy_link(cln_link* l);
+/* gather the distinct links joining soms of the list, returns their number */
+int cln_collect_links(som** soms, int nsoms, cln_link** links, int max);
+/* weight between neuron h of from and neuron i of the other som */
+double cln_link_weight(const cln_link* l, const som* from, int h, int i);
+/* project the activity of the s som onto the d som: out[i] = sum_h act[h]*H[h][i] */
+void cln_link_forward(cln_link* l, const double* act, double* out);
+/* project the activity of the d som onto the s som: out[h] = sum_i H[h][i]*act[i] */
+void cln_link_transposed(cln_link* l, const double* act, double* out);
+/* project the activity of from onto the other som through the matching view */
+void cln_link_project(cln_link* l, const som* from, const double* act, double* out);
+/* same projection without counting tiles, the link is only read so any number of threads can recall through it */
+void cln_link_recall(const cln_link* l, const som* from, const double* act, double* out);
+/* adapt the shared weights from the total activity of both soms and normalize them */
+void cln_update_link(cln_link* l, simopts* so);
+
+#endif
@@ -0,0 +1,229 @@
+/*
+   Unsupervised correlation learning network using self-organizing maps
+
+        Each sensor projects onto a SOM network which will encode
+        the sensory afferent into neural activity. Depending on the
+        global network connectivity (1, 2, 3, ..., N sensory vars)
+        each SOM connects to other SOMs associated with other sensory
+        variables.
+
+        Simple scenario with 2 variables, representing sensory data.
+
+        Trained network compiled into a function lookup table.
+*/
+
+#include "lut.h"
+
+#define CLN_LUT_MAX_DIM	8	// max input vector size of a table
+
+/* sample the src to dst mapping of a trained network on a res points per dimension grid */
+cln_lut* cln_compile_lut(som* src, som* dst, int res)
+{
+	CLN_LOG("cln_compile_lut: Compiling SOM%d to SOM%d mapping on a %d points grid ...\n", src->id, dst->id, res);
+	if(src->insize > CLN_LUT_MAX_DIM || dst->insize > CLN_LUT_MAX_DIM || res < 2){
+		printf("cln_compile_lut: Unsupported table shape.\n");
+		return NULL;
+	}
+	/* each grid point recalls through the whole weights file */
+	if(src->link && src->link->mapped){
+		printf("cln_compile_lut: Mapped cross-modal weights are not compiled, table not built.\n");
+		return NULL;
+	}
+	cln_lut* lut = (cln_lut*)calloc(1, sizeof(cln_lut));
+	lut->indim = src->insize;
+	lut->outdim = dst->insize;
+	lut->res = res;
+	lut->inmin = src->inmin;
+	lut->inmax = src->inmax;
+	lut->step = (lut->inmax - lut->inmin)/(res - 1);
+	long npoints = 1, ncells = 1;
+	for(int d = 0; d < lut->indim; d++){
+		npoints *= res;
+		ncells *= res - 1;
+	}
+	lut->table = (double*)calloc(npoints*lut->outdim, sizeof(double));
+	int nns = src->xsize*src->ysize;
+	double* scratch = (double*)calloc(nns + dst->xsize*dst->ysize, sizeof(double));
+	double* wout = (double*)calloc(nns*lut->outdim, sizeof(double));
+	double* reach = (double*)calloc(nns, sizeof(double));
+	double in[CLN_LUT_MAX_DIM], lo[CLN_LUT_MAX_DIM];
+	int base[CLN_LUT_MAX_DIM];
+	/* run the full recall path on the grid points, first dimension varies slowest */
+	for(long p = 0; p < npoints; p++){
+		for(long d = lut->indim - 1, rem = p; d >= 0; d--, rem /= res)
+			in[d] = lut->inmin + (rem % res)*lut->step;
+		cln_recall(src, dst, in, &lut->table[p*lut->outdim], scratch);
+	}
+	/* the network output only depends on the source winner */
+	for(int idx = 0; idx < nns; idx++)
+		cln_recall_winner(src, dst, idx, &wout[idx*lut->outdim], scratch);
+	/* bound the interpolation error over each cell: the winner is the neuron closest to -W, so the
+	   winners regions are convex and a neuron can only win in the cell if its nearest point of the
+	   cell is closer than the farthest point of every other neuron; the table blends the cell corners,
+	   so the distance to a winner output is largest at a corner */
+	for(long c = 0; c < ncells; c++){
+		for(long d = lut->indim - 1, rem = c; d >= 0; d--, rem /= res - 1){
+			base[d] = rem % (res - 1);
+			lo[d] = lut->inmin + base[d]*lut->step;
+		}
+		double far = DBL_MAX, err = 0.0f;
+		for(int idx = 0; idx < nns; idx++){
+			const double* W = src->neurons[0][idx].W;
+			double dmin = 0.0f, dmax = 0.0f;
+			for(int d = 0; d < lut->indim; d++){
+				double q = -W[d], hi = lo[d] + lut->step;
+				double near = q < lo[d] ? lo[d] : (q > hi ? hi : q);
+				dmin += (near - q)*(near - q);
+				dmax += MAX((lo[d] - q)*(lo[d] - q), (hi - q)*(hi - q));
+			}
+			reach[idx] = dmin;
+			far = MIN(far, dmax);
+		}
+		for(int idx = 0; idx < nns; idx++){
+			if(reach[idx] > far)
+				continue;
+			for(int corner = 0; corner < (1 << lut->indim); corner++){
+				long pidx = 0;
+				for(int d = 0; d < lut->indim; d++)
+					pidx = pidx*res + base[d] + ((corner >> (lut->indim - 1 - d)) & 1);
+				double e = 0.0f;
+				for(int o = 0; o < lut->outdim; o++)
+					e += (wout[idx*lut->outdim + o] - lut->table[pidx*lut->outdim + o])*(wout[idx*lut->outdim + o] - lut->table[pidx*lut->outdim + o]);
+				err = MAX(err, e);
+			}
+		}
+		err = sqrt(err);
+		lut->mean_err += err/ncells;
+		lut->max_err = MAX(lut->max_err, err);
+	}
+	/* a table with a single value means recall ignores its input over the whole domain */
+	long diff = 0;
+	for(long idx = lut->outdim; idx < npoints*lut->outdim; idx++)
+		diff += lut->table[idx] != lut->table[idx % lut->outdim];
+	lut->constant = !diff;
+	if(lut->constant)
+		printf("cln_compile_lut: Warning, SOM%d to SOM%d recall is constant over the sampled domain, the table carries no mapping.\n", src->id, dst->id);
+	else
+		CLN_LOG("cln_compile_lut: %ld points table, error bound against the network max %lf mean %lf.\n", npoints, lut->max_err, lut->mean_err);
+	free(scratch);
+	free(wout);
+	free(reach);
+	return lut;
+}
+
+/* answer a query from the table */
+void cln_query_lut(const cln_lut* lut, const double* in, double* out)
+{
+	int base[CLN_LUT_MAX_DIM];
+	double frac[CLN_LUT_MAX_DIM];
+	/* enclosing cell and position inside it, clamped to the sampled domain */
+	for(int d = 0; d < lut->indim; d++){
+		double t = (in[d] - lut->inmin)/lut->step;
+		t = t < 0 ? 0 : (t > lut->res - 1 ? lut->res - 1 : t);
+		base[d] = MIN((int)t, lut->res - 2);
+		frac[d] = t - base[d];
+	}
+	/* bilinear blend for the common 2D inputs */
+	if(lut->indim == 2){
+		const double* c00 = &lut->table[(base[0]*lut->res + base[1])*lut->outdim];
+		const double* c10 = c00 + lut->res*lut->outdim;
+		for(int o = 0; o < lut->outdim; o++){
+			double lo = c00[o] + frac[1]*(c00[o + lut->outdim] - c00[o]);
+			double hi = c10[o] + frac[1]*(c10[o + lut->outdim] - c10[o]);
+			out[o] = lo + frac[0]*(hi - lo);
+		}
+		return;
+	}
+	for(int o = 0; o < lut->outdim; o++)
+		out[o] = 0.0f;
+	/* blend the cell corners */
+	for(int corner = 0; corner < (1 << lut->indim); corner++){
+		double w = 1.0f;
+		long idx = 0;
+		for(int d = 0; d < lut->indim; d++){
+			int bit = (corner >> (lut->indim - 1 - d)) & 1;
+			w *= bit ? frac[d] : 1.0f - frac[d];
+			idx = idx*lut->res + base[d] + bit;
+		}
+		for(int o = 0; o < lut->outdim; o++)
+			out[o] += w*lut->table[idx*lut->outdim + o];
+	}
+}
+
+/* save a table to disk */
+int cln_save_lut(const cln_lut* lut, char* file)
+{
+	FILE* fout = fopen(file, "wb");
+	if(!fout){
+		printf("cln_save_lut: Cannot create table file %s.\n", file);
+		return -1;
+	}
+	unsigned int magic = CLN_LUT_MAGIC;
+	long npoints = 1;
+	for(int d = 0; d < lut->indim; d++)
+		npoints *= lut->res;
+	/* shape and domain field by field, then the grid outputs */
+	fwrite(&magic, sizeof(magic), 1, fout);
+	fwrite(&lut->indim, sizeof(int), 1, fout);
+	fwrite(&lut->outdim, sizeof(int), 1, fout);
+	fwrite(&lut->res, sizeof(int), 1, fout);
+	fwrite(&lut->inmin, sizeof(double), 1, fout);
+	fwrite(&lut->inmax, sizeof(double), 1, fout);
+	fwrite(&lut->max_err, sizeof(double), 1, fout);
+	fwrite(&lut->mean_err, sizeof(double), 1, fout);
+	fwrite(lut->table, sizeof(double), npoints*lut->outdim, fout);
+	if(fclose(fout)){
+		printf("cln_save_lut: Cannot write table file %s.\n", file);
+		return -1;
+	}
+	CLN_LOG("cln_save_lut: Saved table to %s.\n", file);
+	return EXIT_SUCCESS;
+}
+
+/* load a table saved with cln_save_lut */
+cln_lut* cln_load_lut(char* file)
+{
+	unsigned int magic = 0;
+	FILE* fin = fopen(file, "rb");
+	if(!fin){
+		printf("cln_load_lut: Cannot open table file %s.\n", file);
+		return NULL;
+	}
+	cln_lut* lut = (cln_lut*)calloc(1, sizeof(cln_lut));
+	int ok = fread(&magic, sizeof(magic), 1, fin) == 1 && magic == CLN_LUT_MAGIC &&
+		 fread(&lut->indim, sizeof(int), 1, fin) == 1 && fread(&lut->outdim, sizeof(int), 1, fin) == 1 &&
+		 fread(&lut->res, sizeof(int), 1, fin) == 1 && fread(&lut->inmin, sizeof(double), 1, fin) == 1 &&
+		 fread(&lut->inmax, sizeof(double), 1, fin) == 1 && fread(&lut->max_err, sizeof(double), 1, fin) == 1 &&
+		 fread(&lut->mean_err, sizeof(double), 1, fin) == 1;
+	/* the query indexes the grid from these, reject shapes it cannot handle */
+	ok = ok && lut->indim >= 1 && lut->indim <= CLN_LUT_MAX_DIM && lut->outdim >= 1 && lut->outdim <= CLN_LUT_MAX_DIM &&
+	     lut->res >= 2 && lut->inmax > lut->inmin;
+	long npoints = 1;
+	for(int d = 0; ok && d < lut->indim; d++){
+		ok = npoints <= LONG_MAX/lut->res/lut->outdim/(long)sizeof(double);
+		npoints *= lut->res;
+	}
+	if(!ok){
+		printf("cln_load_lut: %s is not a table file.\n", file);
+		fclose(fin);
+		free(lut);
+		return NULL;
+	}
+	lut->step = (lut->inmax - lut->inmin)/(lut->res - 1);
+	lut->table = (double*)calloc(npoints*lut->outdim, sizeof(double));
+	if(!lut->table || fread(lut->table, sizeof(double), npoints*lut->outdim, fin) != (size_t)(npoints*lut->outdim)){
+		printf("cln_load_lut: Truncated table file %s.\n", file);
+		fclose(fin);
+		cln_destroy_lut(lut);
+		return NULL;
+	}
+	fclose(fin);
+	return lut;
+}
+
+/* release a table */
+void cln_destroy_lut(cln_lut* lut)
+{
+	free(lut->table);
+	free(lut);
+}
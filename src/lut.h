@@ -0,0 +1,58 @@
+/*
+   Unsupervised correlation learning network using self-organizing maps
+
+        Each sensor projects onto a SOM network which will encode
+        the sensory afferent into neural activity. Depending on the
+        global network connectivity (1, 2, 3, ..., N sensory vars)
+        each SOM connects to other SOMs associated with other sensory
+        variables.
+
+        Simple scenario with 2 variables, representing sensory data.
+
+        Trained network compiled into a function lookup table.
+
+        The source som input domain (inmin..inmax on every component) is
+        sampled on a regular grid, each grid point is run through the full
+        recall path and queries are answered by multilinear interpolation
+        between the grid points. The recalled output only depends on the
+        source winner, so the error against the network is bounded per cell
+        from the neurons that can win inside it rather than sampled.
+
+        File layout: magic, indim, outdim, res (int), inmin, inmax, max_err,
+        mean_err (double), then the grid outputs (res^indim x outdim).
+*/
+
+#ifndef CLN_LUT_H
+#define CLN_LUT_H
+
+#include <limits.h>
+#include "link.h"
+
+#define CLN_LUT_MAGIC	0x434c4e4cU	// "CLNL"
+
+/* function lookup table */
+typedef struct{
+	int indim;		// input vector size (source som)
+	int outdim;		// output vector size (destination som)
+	int res;		// grid points per input dimension
+	double inmin;		// lower bound of the sampled domain
+	double inmax;		// upper bound of the sampled domain
+	double step;		// grid step
+	double max_err;		// bound on the distance to the network output over the domain
+	double mean_err;	// mean of the per cell bounds
+	int constant;		// recall ignores the input over the whole domain
+	double* table;		// network output at the grid points (res^indim x outdim)
+}cln_lut;
+
+/* sample the src to dst mapping of a trained network on a res points per dimension grid */
+cln_lut* cln_compile_lut(som* src, som* dst, int res);
+/* answer a query from the table */
+void cln_query_lut(const cln_lut* lut, const double* in, double* out);
+/* save a table to disk */
+int cln_save_lut(const cln_lut* lut, char* file);
+/* load a table saved with cln_save_lut */
+cln_lut* cln_load_lut(char* file);
+/* release a table */
+void cln_destroy_lut(cln_lut* lut);
+
+#endif
@@ -13,6 +13,11 @@
 */
 
 #include "data.h"
+#include "publish.h"
+#include "trajectory.h"
+#include "pipeline.h"
+#include "lut.h"
+#include "model.h"
 
 /* simulation parms */
 #define NET_SIZE	2 			// number of soms in the network
@@ -20,6 +25,9 @@
 #define INPUT_SIZE	2			// input vector size
 #define NUM_IN_VEC	10			// number of input vectors
 #define SENSOR_DATASET	"robot_data_jras_paper" // sensory data file
+#define SENSOR_COL1	7			// first sensor data column feeding som1
+#define SENSOR_COL2	9			// first sensor data column feeding som2
+#define CHUNK_LEN	1024			// samples per input pipeline chunk
 #define DATA_SOURCE	ARTIFICIAL_DATA		// network input source
 /* network params */
 #define NET_SOM_SIZEX	10			// soms size on X axis
@@ -34,6 +42,26 @@
 #define TAU		500					// time constant for learning adaptation
 #define LAMDA		MAX_EPOCHS/log(SIGMA0)  		// time constant for radius adaptation
 #define XMOD_LEARNING	HEBBIAN
+#define XMOD_BACKING	NULL					// file backing the cross-modal weights (NULL keeps them in memory), disables publication, recording and tables, the model references it
+#define XMOD_ACT_EPS	1e-3					// activity below which mapped weight tiles are skipped
+/* early stopping params */
+#define ES_PATIENCE	10					// plateaued epochs before stopping (0 to always run MAX_EPOCHS)
+#define ES_TOLERANCE	1e-3					// relative change of each metric counted as a plateau
+#define ES_DECAY	0.75f					// fraction of the initial neighborhood radius below which plateaus are counted
+/* trained model params */
+#define MODEL_FILE	"cln_model.bin"				// trained model, evaluate with cln_eval
+/* function table export params */
+#define LUT_RES		64					// grid points per input dimension (0 to disable)
+#define LUT_FILE12	"cln_lut_som1_som2.bin"			// som1 to som2 mapping table
+#define LUT_FILE21	"cln_lut_som2_som1.bin"			// som2 to som1 mapping table
+/* model publication params */
+#define PUBLISH_EPOCHS	10					// epochs between shared model snapshots (0 to disable)
+#define PUBLISH_NAME	"/cln_model"				// shared memory object of the published model
+#define PUBLISH_KEEP	1					// keep the final model in shared memory after exit (read with cln_shm_reader)
+/* training trajectory params */
+#define RECORD_EPOCHS	10					// epochs between trajectory snapshots (0 to disable)
+#define RECORD_QUEUE	8					// snapshots queued for the background writer
+#define RECORD_FILE	"cln_trajectory.bin"			// trajectory file, convert with cln_traj2txt
 
 /* entry point */
 int main(int argc, char** argv)
@@ -43,22 +71,54 @@ int main(int argc, char** argv)
 	/* debug ASCII encoded files - remove in production code */	
 	char* debug_som1 = NULL;
 	char* debug_som2 = NULL;
+	/* shared model for local readers */
+	cln_publisher* publisher = NULL;
+	/* training trajectory recorder */
+	cln_recorder* recorder = NULL;
+	/* input pipeline */
+	cln_pipeline* pipeline = NULL;
+	cln_chunk* chunk = NULL;
 	/* create the SOM nets of the net */
 	som* som1 = cln_create_som(1, NET_SOM_SIZEX, NET_SOM_SIZEY, INPUT_SIZE, 2, 12);
 	som* som2 = cln_create_som(2, NET_SOM_SIZEX, NET_SOM_SIZEY, INPUT_SIZE, 8, 48);
+	/* connect the SOM nets through a shared cross-modal link */
+	cln_link* link = XMOD_BACKING ? cln_create_mapped_link(som1, som2, XMOD_BACKING, XMOD_ACT_EPS)
+				      : cln_create_link(som1, som2);
+	if(!link)
+		return EXIT_FAILURE;
 	/* prepare simulation params */
 	simopts* simulation = cln_setup_simulation(ADAPTIVE_PARAMS, 
 						   ALPHA0, SIGMA0, GAMMA0, XI0, KAPPA0, 
 						   DATA_SOURCE, 
 						   MAX_EPOCHS, 
 						   XMOD_LEARNING);
-	/* build the input datasets */
-	indataset* ind1 = cln_create_input_dataset(som1->id, DATA_SOURCE, INPUT_SIZE, NUM_IN_VEC, SENSOR_DATASET);
-	indataset* ind2 = cln_create_input_dataset(som2->id, DATA_SOURCE, INPUT_SIZE, NUM_IN_VEC, SENSOR_DATASET);
+	cln_set_early_stopping(simulation, ES_PATIENCE, ES_TOLERANCE, ES_DECAY);
+	/* build the input datasets, the sensor log is streamed by the pipeline instead of read up front */
+	indataset* ind1 = NULL;
+	indataset* ind2 = NULL;
+	if(DATA_SOURCE!=SENSOR_DATA){
+		ind1 = cln_create_input_dataset(som1->id, DATA_SOURCE, INPUT_SIZE, NUM_IN_VEC, SENSOR_DATASET);
+		ind2 = cln_create_input_dataset(som2->id, DATA_SOURCE, INPUT_SIZE, NUM_IN_VEC, SENSOR_DATASET);
+	}
+	/* overlap input loading with training */
+	indataset* ind[NET_SIZE] = {ind1, ind2};
+	int sensor_cols[NET_SIZE] = {SENSOR_COL1, SENSOR_COL2};
+	pipeline = cln_create_pipeline(DATA_SOURCE==SENSOR_DATA ? cln_sensor_file_source(SENSOR_DATASET, sensor_cols, NET_SIZE) :
+								    cln_dataset_source(ind, NET_SIZE),
+				       NET_SIZE, INPUT_SIZE, CHUNK_LEN);
+	if(!pipeline)
+		return EXIT_FAILURE;
+	/* publish the model in shared memory for concurrent readers */
+	som* net[NET_SIZE] = {som1, som2};
+	if(PUBLISH_EPOCHS > 0)
+		publisher = cln_create_publisher(PUBLISH_NAME, net, NET_SIZE);
+	/* record the training trajectory in the background */
+	if(RECORD_EPOCHS > 0)
+		recorder = cln_create_recorder(RECORD_FILE, net, NET_SIZE, RECORD_EPOCHS, RECORD_QUEUE);
 	/* -------------------------------------------------------------------------------------------------------------------------------------------*/
 	/* loop the network */
 	while(1){
-		if(net_iter++<=MAX_EPOCHS){
+		if(++net_iter<simulation->simepochs){
 			/* adaptation parameters check */
 			if(simulation->paramsupdate==ADAPTIVE_PARAMS){
 				/* compute the adaptation params */
@@ -77,27 +137,38 @@ int main(int argc, char** argv)
 							  XI0,
 							  KAPPA0);
 			}
-			/* present a vector from the dataset to the network - plastic afferent sensory projections weights */
-			for(int data_iter = 0; data_iter<NUM_IN_VEC; data_iter++){	
-				/* get the current value of the simulation params */
-				som1->params = cln_get_simulation_params(simulation);
-				som2->params = cln_get_simulation_params(simulation);
-				/* present data to som nets, find bmus and compute sensory elicited activity */
-				cln_compute_sensory_activation(som1, cln_find_sensory_bmu(som1, ind1->data[data_iter]));
-   			        cln_compute_sensory_activation(som2, cln_find_sensory_bmu(som2, ind2->data[data_iter]));
-   			        /* compute the cross modal activation by cross propagating the sensory elicited activity */
-				cln_compute_xmodal_activation(som1, cln_find_xmodal_bmu(som2, som1));
-				cln_compute_xmodal_activation(som2, cln_find_xmodal_bmu(som1, som2));	
-				/* compute the total activation in each som */
-				cln_compute_joint_activation(som1);
-				cln_compute_joint_activation(som2);
-				/* update the sensory projection weights */
-			        cln_compute_sensory_weights(som1, ind1->data[data_iter]);		
-				cln_compute_sensory_weights(som2, ind2->data[data_iter]);
-				/* update the cross-modal hebbian links */
-				cln_compute_xmodal_weights(som1, som2);
-				cln_compute_xmodal_weights(som2, som1);
-		}				
+			/* present the chunks loaded by the pipeline to the network - plastic afferent sensory projections weights */
+			while((chunk = cln_pipeline_next(pipeline))){
+				for(int data_iter = 0; data_iter<chunk->len; data_iter++){	
+					double* in1 = CLN_CHUNK_SAMPLE(chunk, 0, data_iter);
+					double* in2 = CLN_CHUNK_SAMPLE(chunk, 1, data_iter);
+					/* get the current value of the simulation params */
+					som1->params = cln_get_simulation_params(simulation);
+					som2->params = cln_get_simulation_params(simulation);
+					/* present data to som nets, find bmus and compute sensory elicited activity */
+					cln_compute_sensory_activation(som1, cln_find_sensory_bmu(som1, in1));
+					cln_compute_sensory_activation(som2, cln_find_sensory_bmu(som2, in2));
+					/* compute the cross modal activation by cross propagating the sensory elicited activity */
+					cln_compute_xmodal_activation(som1, cln_find_xmodal_bmu(som2, som1));
+					cln_compute_xmodal_activation(som2, cln_find_xmodal_bmu(som1, som2));	
+					/* compute the total activation in each som */
+					cln_compute_joint_activation(som1);
+					cln_compute_joint_activation(som2);
+					/* update the sensory projection weights */
+					cln_compute_sensory_weights(som1, in1);		
+					cln_compute_sensory_weights(som2, in2);
+					/* update the cross-modal hebbian links, shared by both soms */
+					cln_compute_xmodal_weights(som1, som2);
+				}
+			}
+			/* publish a consistent snapshot for the readers */
+			if(publisher && net_iter%PUBLISH_EPOCHS==0)
+				cln_publish_model(publisher, net_iter);
+			/* snapshot the maps development */
+			if(recorder)
+				cln_record_epoch(recorder, simulation, net_iter);
+			/* stop once the maps settled */
+			cln_check_convergence(simulation, net, NET_SIZE);
 		}
 		else{
 			printf("cln_main: Finalized training phase.\n");
@@ -105,12 +176,15 @@ int main(int argc, char** argv)
 		}
 	}
 	/* -------------------------------------------------------------------------------------------------*/
+	/* publish the final model, the training may stop between snapshots */
+	if(publisher)
+		cln_publish_model(publisher, simulation->cur_epoch);
 	/* get post simulation data */
 	simopts* sim_par_final = cln_get_simulation_params(simulation);	
 	/* display som data */
 	cln_display_som(som1);
 	cln_display_som(som2);
-	/* build the output datasets */
+	/* build the output datasets, the dump only keeps the params and the soms so streamed runs have no input dataset */
 	outdataset* outd1 = cln_create_output_dataset(sim_par_final, ind1, som1);
 	outdataset* outd2 = cln_create_output_dataset(sim_par_final, ind2, som2);
 	/* dump data file */
@@ -119,7 +193,30 @@ int main(int argc, char** argv)
 	/* dump the debug data file - ASCII encoded data */
 	cln_read_output_dataset(debug_som1);
 	cln_read_output_dataset(debug_som2);
+	/* save the trained model for offline evaluation */
+	cln_save_model(som1, som2, MODEL_FILE);
+	/* compile the learned mapping into lookup tables */
+	if(LUT_RES > 0){
+		cln_lut* lut12 = cln_compile_lut(som1, som2, LUT_RES);
+		cln_lut* lut21 = cln_compile_lut(som2, som1, LUT_RES);
+		/* a constant table carries no mapping, keep no file of it */
+		if(lut12 && !lut12->constant)
+			cln_save_lut(lut12, LUT_FILE12);
+		if(lut21 && !lut21->constant)
+			cln_save_lut(lut21, LUT_FILE21);
+		if(lut12)
+			cln_destroy_lut(lut12);
+		if(lut21)
+			cln_destroy_lut(lut21);
+	}
 	/* free up resources */
+	cln_destroy_pipeline(pipeline);
+	if(recorder)
+		cln_destroy_recorder(recorder);
+	if(publisher)
+		cln_destroy_publisher(publisher, PUBLISH_KEEP);
+	cln_report_link(link);
+	cln_destroy_link(link);
 	cln_destroy_som(som1);
 	cln_destroy_som(som2);
 
@@ -0,0 +1,206 @@
+/*
+   Unsupervised correlation learning network using self-organizing maps
+
+        Each sensor projects onto a SOM network which will encode
+        the sensory afferent into neural activity. Depending on the
+        global network connectivity (1, 2, 3, ..., N sensory vars)
+        each SOM connects to other SOMs associated with other sensory
+        variables.
+
+        Simple scenario with 2 variables, representing sensory data.
+
+        Trained model files.
+*/
+
+#include "model.h"
+
+/* shape of a som as saved */
+static cln_model_som cln_model_shape(const som* s)
+{
+	cln_model_som ms = {s->id, s->xsize, s->ysize, s->insize, s->inmin, s->inmax};
+	return ms;
+}
+
+/* save the linked soms s and d with the current simulation params */
+int cln_save_model(som* s, som* d, char* file)
+{
+	cln_link* l = s->link;
+	if(!l || l->s != s || l->d != d){
+		printf("cln_save_model: SOM%d and SOM%d do not share a link.\n", s->id, d->id);
+		return -1;
+	}
+	/* a mapped link keeps its weights in its own file, flush them and reference the file */
+	char* backing = NULL;
+	if(l->mapped && (cln_sync_link(l) < 0 || !(backing = realpath(l->file, NULL)))){
+		printf("cln_save_model: Cannot reference cross-modal weights file %s.\n", l->file);
+		return -1;
+	}
+	FILE* fout = fopen(file, "wb");
+	if(!fout){
+		printf("cln_save_model: Cannot create model file %s.\n", file);
+		free(backing);
+		return -1;
+	}
+	cln_model_header hdr;
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = CLN_MODEL_MAGIC;
+	hdr.version = CLN_MODEL_VERSION;
+	hdr.learn_rule = s->params->learn_rule;
+	hdr.epoch = s->params->cur_epoch;
+	hdr.sigma = s->params->sigma[s->params->cur_epoch];
+	hdr.act_eps = l->act_eps;
+	hdr.backing = backing ? strlen(backing) : 0;
+	cln_model_som shapes[2] = {cln_model_shape(s), cln_model_shape(d)};
+	fwrite(&hdr, sizeof(hdr), 1, fout);
+	fwrite(shapes, sizeof(cln_model_som), 2, fout);
+	if(backing)
+		fwrite(backing, 1, hdr.backing, fout);
+	fwrite(s->neurons[0][0].W, sizeof(double), (size_t)l->ns*s->insize, fout);
+	fwrite(d->neurons[0][0].W, sizeof(double), (size_t)l->nd*d->insize, fout);
+	if(!backing)
+		fwrite(l->H, sizeof(double), (size_t)l->ns*l->nd, fout);
+	free(backing);
+	if(fclose(fout)){
+		printf("cln_save_model: Cannot write model file %s.\n", file);
+		return -1;
+	}
+	CLN_LOG("cln_save_model: Saved SOM%d-SOM%d model to %s.\n", s->id, d->id, file);
+	return EXIT_SUCCESS;
+}
+
+/* open a model file and read its header, som shapes and link weights file name (NULL when the weights are in the model) */
+static FILE* cln_open_model(char* file, cln_model_header* hdr, cln_model_som* shapes, char** backing)
+{
+	FILE* fin = fopen(file, "rb");
+	*backing = NULL;
+	if(!fin){
+		printf("cln_open_model: Cannot open model file %s.\n", file);
+		return NULL;
+	}
+	if(fread(hdr, sizeof(cln_model_header), 1, fin) != 1 || hdr->magic != CLN_MODEL_MAGIC || hdr->version != CLN_MODEL_VERSION ||
+	   hdr->backing < 0 || hdr->backing > PATH_MAX || fread(shapes, sizeof(cln_model_som), 2, fin) != 2){
+		printf("cln_open_model: %s is not a model file.\n", file);
+		fclose(fin);
+		return NULL;
+	}
+	for(int idx = 0; idx < 2; idx++){
+		/* the soms are allocated from these, reject empty shapes before sizing anything */
+		if(shapes[idx].xsize <= 0 || shapes[idx].ysize <= 0 || shapes[idx].insize <= 0){
+			printf("cln_open_model: %s holds an empty som shape %dx%dx%d.\n", file, shapes[idx].xsize, shapes[idx].ysize, shapes[idx].insize);
+			fclose(fin);
+			return NULL;
+		}
+	}
+	if(hdr->backing){
+		*backing = (char*)calloc(hdr->backing + 1, sizeof(char));
+		if(fread(*backing, 1, hdr->backing, fin) != (size_t)hdr->backing){
+			printf("cln_open_model: Truncated model file %s.\n", file);
+			free(*backing);
+			*backing = NULL;
+			fclose(fin);
+			return NULL;
+		}
+	}
+	return fin;
+}
+
+/* read the sensory weights of s and d following the header into ws and wd, then the cross-modal weights from hin into h */
+static int cln_read_weights(FILE* fin, FILE* hin, const som* s, const som* d, double* ws, double* wd, double* h)
+{
+	size_t ns = s->xsize*s->ysize, nd = d->xsize*d->ysize;
+	size_t nws = ns*s->insize, nwd = nd*d->insize, nh = ns*nd;
+	if(fread(ws, sizeof(double), nws, fin) != nws ||
+	   fread(wd, sizeof(double), nwd, fin) != nwd ||
+	   (hin && fread(h, sizeof(double), nh, hin) != nh))
+		return -1;
+	return EXIT_SUCCESS;
+}
+
+/* load a model saved with cln_save_model */
+cln_model* cln_load_model(char* file)
+{
+	cln_model_header hdr;
+	cln_model_som shapes[2];
+	char* backing;
+	FILE* fin = cln_open_model(file, &hdr, shapes, &backing);
+	if(!fin)
+		return NULL;
+	cln_model* m = (cln_model*)calloc(1, sizeof(cln_model));
+	m->s = cln_create_som(shapes[0].id, shapes[0].xsize, shapes[0].ysize, shapes[0].insize, shapes[0].inmin, shapes[0].inmax);
+	m->d = cln_create_som(shapes[1].id, shapes[1].xsize, shapes[1].ysize, shapes[1].insize, shapes[1].inmin, shapes[1].inmax);
+	/* recall only needs the neighborhood size, a single epoch holds it */
+	m->params = cln_setup_simulation(FIXED_PARAMS, 0.0f, hdr.sigma, 0.0f, 0.0f, 0.0f, 0, 1, hdr.learn_rule);
+	m->s->params = m->params;
+	m->d->params = m->params;
+	/* out of core models map their link weights file again */
+	m->link = backing ? cln_open_mapped_link(m->s, m->d, backing, hdr.act_eps) : cln_create_link(m->s, m->d);
+	free(backing);
+	if(!m->link || cln_read_weights(fin, m->link->mapped ? NULL : fin, m->s, m->d,
+					m->s->neurons[0][0].W, m->d->neurons[0][0].W, m->link->H) < 0){
+		printf("cln_load_model: Cannot load model file %s.\n", file);
+		fclose(fin);
+		cln_destroy_model(m);
+		return NULL;
+	}
+	fclose(fin);
+	CLN_LOG("cln_load_model: Loaded SOM%d-SOM%d model from %s.\n", m->s->id, m->d->id, file);
+	return m;
+}
+
+/* restore the weights of a model into linked soms of the same shape, returns the saved epoch, the soms are unchanged on failure */
+int cln_restore_model(som* s, som* d, char* file)
+{
+	cln_model_header hdr;
+	cln_model_som shapes[2];
+	char* backing;
+	FILE* fin = cln_open_model(file, &hdr, shapes, &backing);
+	if(!fin)
+		return -1;
+	cln_model_som cur[2] = {cln_model_shape(s), cln_model_shape(d)};
+	for(int idx = 0; idx < 2; idx++){
+		if(cur[idx].xsize != shapes[idx].xsize || cur[idx].ysize != shapes[idx].ysize || cur[idx].insize != shapes[idx].insize){
+			printf("cln_restore_model: SOM%d shape does not match the model in %s.\n", cur[idx].id, file);
+			fclose(fin);
+			free(backing);
+			return -1;
+		}
+	}
+	/* the link weights of an out of core model are read from its weights file */
+	FILE* hin = backing ? fopen(backing, "rb") : fin;
+	cln_link* l = s->link;
+	int ok = l && l->s == s && l->d == d && hin;
+	/* stage everything so a truncated model leaves the soms untouched */
+	size_t nws = (size_t)cur[0].xsize*cur[0].ysize*cur[0].insize, nwd = (size_t)cur[1].xsize*cur[1].ysize*cur[1].insize;
+	double* ws = ok ? (double*)malloc(nws*sizeof(double)) : NULL;
+	double* wd = ok ? (double*)malloc(nwd*sizeof(double)) : NULL;
+	double* h = ok ? (double*)malloc((size_t)l->ns*l->nd*sizeof(double)) : NULL;
+	ok = ok && ws && wd && h && cln_read_weights(fin, hin, s, d, ws, wd, h) == EXIT_SUCCESS;
+	if(ok){
+		memcpy(s->neurons[0][0].W, ws, nws*sizeof(double));
+		memcpy(d->neurons[0][0].W, wd, nwd*sizeof(double));
+		memcpy(l->H, h, (size_t)l->ns*l->nd*sizeof(double));
+	}
+	else
+		printf("cln_restore_model: Cannot restore SOM%d-SOM%d from %s.\n", s->id, d->id, file);
+	free(ws);
+	free(wd);
+	free(h);
+	if(hin && hin != fin)
+		fclose(hin);
+	fclose(fin);
+	free(backing);
+	if(!ok)
+		return -1;
+	CLN_LOG("cln_restore_model: Restored SOM%d-SOM%d from %s at epoch %d.\n", s->id, d->id, file, hdr.epoch);
+	return hdr.epoch;
+}
+
+/* release a loaded model */
+void cln_destroy_model(cln_model* m)
+{
+	cln_destroy_link(m->link);
+	cln_destroy_som(m->s);
+	cln_destroy_som(m->d);
+	cln_destroy_simulation(m->params);
+	free(m);
+}
@@ -0,0 +1,76 @@
+/*
+   Unsupervised correlation learning network using self-organizing maps
+
+        Each sensor projects onto a SOM network which will encode
+        the sensory afferent into neural activity. Depending on the
+        global network connectivity (1, 2, 3, ..., N sensory vars)
+        each SOM connects to other SOMs associated with other sensory
+        variables.
+
+        Simple scenario with 2 variables, representing sensory data.
+
+        Trained model files.
+
+        A model is the pair of linked soms with everything the recall
+        path needs: the lattice shapes and input domains, the sensory
+        weights, the shared cross-modal weights and the final neighborhood
+        size. Loaded models run the recall path exactly as at the end of
+        training. The epoch the model was saved at lets a checkpoint be
+        restored into soms of the same shape to resume training.
+
+        File layout: cln_model_header, 2 x cln_model_som, the sensory
+        weights of each som (nn*insize), then the link weights (ns x nd,
+        row major, s som on the rows). A mapped link is too large to copy,
+        its weights stay in their own file: the model then holds the
+        absolute name of that file (backing bytes) right after the som
+        shapes instead of the link weights, and loading maps it again.
+*/
+
+#ifndef CLN_MODEL_H
+#define CLN_MODEL_H
+
+#include <limits.h>
+#include "link.h"
+
+#define CLN_MODEL_MAGIC		0x434c4e53U	// "CLNS"
+#define CLN_MODEL_VERSION	1
+
+/* model file header */
+typedef struct{
+	unsigned int magic;	// file tag
+	int version;		// format version
+	short learn_rule;	// cross-modal learning rule the model was trained with
+	int epoch;		// training epoch the model was saved at
+	double sigma;		// neighborhood size at the end of training
+	double act_eps;		// tile activity threshold of a mapped link
+	int backing;		// length of the link weights file name, 0 when the weights are in the model
+}cln_model_header;
+
+/* saved som shape */
+typedef struct{
+	short id;		// id of the network
+	short xsize;		// size of the network x dimension
+	short ysize;		// size of the network y dimension
+	short insize;		// input vector size
+	double inmin;		// lower bound of the input domain
+	double inmax;		// upper bound of the input domain
+}cln_model_som;
+
+/* loaded model */
+typedef struct{
+	som* s;			// som on the link rows
+	som* d;			// som on the link columns
+	cln_link* link;		// shared cross-modal weights
+	simopts* params;	// single epoch params holding the final neighborhood size
+}cln_model;
+
+/* save the linked soms s and d with the current simulation params */
+int cln_save_model(som* s, som* d, char* file);
+/* load a model saved with cln_save_model */
+cln_model* cln_load_model(char* file);
+/* restore the weights of a model into linked soms of the same shape, returns the saved epoch, the soms are unchanged on failure */
+int cln_restore_model(som* s, som* d, char* file);
+/* release a loaded model */
+void cln_destroy_model(cln_model* m);
+
+#endif
@@ -0,0 +1,236 @@
+/*
+   Unsupervised correlation learning network using self-organizing maps
+
+        Each sensor projects onto a SOM network which will encode
+        the sensory afferent into neural activity. Depending on the
+        global network connectivity (1, 2, 3, ..., N sensory vars)
+        each SOM connects to other SOMs associated with other sensory
+        variables.
+
+        Simple scenario with 2 variables, representing sensory data.
+
+        Double buffered input pipeline.
+*/
+
+#include "pipeline.h"
+
+/* chunk buffer states */
+enum{
+	CHUNK_FREE = 0,
+	CHUNK_READY,
+	CHUNK_IN_USE
+};
+
+/* in memory datasets source state */
+typedef struct{
+	indataset** ind;	// dataset of each stream
+	int pos;		// next sample
+}cln_dataset_ctx;
+
+/* sensor logs source state */
+typedef struct{
+	FILE* fin;		// sensor log
+	int* cols;		// first column of each stream
+	char line[4096];	// line buffer
+}cln_sensor_ctx;
+
+/* copy the next samples of the in memory datasets */
+static int cln_dataset_fill(void* ctx, double** data, int nstreams, int vsize, int len)
+{
+	cln_dataset_ctx* dc = (cln_dataset_ctx*)ctx;
+	int n = 0;
+	for(; n < len && dc->pos < dc->ind[0]->len; n++, dc->pos++)
+		for(int sidx = 0; sidx < nstreams; sidx++)
+			memcpy(&data[sidx][n*vsize], dc->ind[sidx]->data[dc->pos], vsize*sizeof(double));
+	return n;
+}
+
+static void cln_dataset_rewind(void* ctx)
+{
+	((cln_dataset_ctx*)ctx)->pos = 0;
+}
+
+static void cln_dataset_close(void* ctx)
+{
+	free(ctx);
+}
+
+/* source iterating over in memory datasets, one per stream */
+cln_source cln_dataset_source(indataset** ind, int nstreams)
+{
+	(void)nstreams;
+	cln_dataset_ctx* dc = (cln_dataset_ctx*)calloc(1, sizeof(cln_dataset_ctx));
+	dc->ind = ind;
+	cln_source src = {cln_dataset_fill, cln_dataset_rewind, cln_dataset_close, dc};
+	return src;
+}
+
+/* parse the next sensor log lines - timestamp followed by the sensor columns */
+static int cln_sensor_fill(void* ctx, double** data, int nstreams, int vsize, int len)
+{
+	cln_sensor_ctx* sc = (cln_sensor_ctx*)ctx;
+	int n = 0;
+	while(n < len && fgets(sc->line, sizeof(sc->line), sc->fin)){
+		double vals[128];
+		int nvals = 0;
+		char* cur = sc->line;
+		char* end = NULL;
+		/* skip the timestamp */
+		strtod(cur, &end);
+		if(end == cur)
+			continue;
+		for(cur = end; nvals < 128; cur = end){
+			vals[nvals] = strtod(cur, &end);
+			if(end == cur)
+				break;
+			nvals++;
+		}
+		int valid = 1;
+		for(int sidx = 0; sidx < nstreams; sidx++)
+			valid &= sc->cols[sidx] + vsize <= nvals;
+		if(!valid)
+			continue;
+		for(int sidx = 0; sidx < nstreams; sidx++)
+			memcpy(&data[sidx][n*vsize], &vals[sc->cols[sidx]], vsize*sizeof(double));
+		n++;
+	}
+	return n;
+}
+
+static void cln_sensor_rewind(void* ctx)
+{
+	rewind(((cln_sensor_ctx*)ctx)->fin);
+}
+
+static void cln_sensor_close(void* ctx)
+{
+	cln_sensor_ctx* sc = (cln_sensor_ctx*)ctx;
+	fclose(sc->fin);
+	free(sc->cols);
+	free(sc);
+}
+
+/* source streaming sensor logs, stream s reads vsize columns from cols[s] */
+cln_source cln_sensor_file_source(char* data_file, int* cols, int nstreams)
+{
+	cln_source src = {NULL, NULL, NULL, NULL};
+	FILE* fin = fopen(data_file, "r");
+	if(!fin){
+		printf("cln_sensor_file_source: Cannot open sensor data file %s.\n", data_file);
+		return src;
+	}
+	cln_sensor_ctx* sc = (cln_sensor_ctx*)calloc(1, sizeof(cln_sensor_ctx));
+	sc->fin = fin;
+	sc->cols = (int*)calloc(nstreams, sizeof(int));
+	memcpy(sc->cols, cols, nstreams*sizeof(int));
+	src.fill = cln_sensor_fill;
+	src.rewind = cln_sensor_rewind;
+	src.close = cln_sensor_close;
+	src.ctx = sc;
+	return src;
+}
+
+/* loader thread - fills free buffers, rewinds the source after each pass */
+static void* cln_pipeline_loader(void* arg)
+{
+	cln_pipeline* p = (cln_pipeline*)arg;
+	while(1){
+		cln_chunk* c = &p->chunks[p->load_idx];
+		double t0 = cln_now();
+		pthread_mutex_lock(&p->lock);
+		while(c->state != CHUNK_FREE && !p->stop)
+			pthread_cond_wait(&p->changed, &p->lock);
+		p->load_stall += cln_now() - t0;
+		if(p->stop){
+			pthread_mutex_unlock(&p->lock);
+			break;
+		}
+		pthread_mutex_unlock(&p->lock);
+		/* the free buffer belongs to the loader until marked ready */
+		c->len = p->src.fill(p->src.ctx, c->data, p->nstreams, p->vsize, p->chunk_len);
+		if(c->len == 0)
+			p->src.rewind(p->src.ctx);
+		pthread_mutex_lock(&p->lock);
+		p->loaded += c->len;
+		c->state = CHUNK_READY;
+		pthread_cond_broadcast(&p->changed);
+		pthread_mutex_unlock(&p->lock);
+		p->load_idx ^= 1;
+	}
+	return NULL;
+}
+
+/* start the pipeline loading chunks of chunk_len samples */
+cln_pipeline* cln_create_pipeline(cln_source src, int nstreams, int vsize, int chunk_len)
+{
+	if(!src.fill){
+		printf("cln_create_pipeline: No input source.\n");
+		return NULL;
+	}
+	cln_pipeline* p = (cln_pipeline*)calloc(1, sizeof(cln_pipeline));
+	p->src = src;
+	p->nstreams = nstreams;
+	p->vsize = vsize;
+	p->chunk_len = chunk_len;
+	for(int idx = 0; idx < 2; idx++){
+		p->chunks[idx].vsize = vsize;
+		p->chunks[idx].state = CHUNK_FREE;
+		p->chunks[idx].data = (double**)calloc(nstreams, sizeof(double*));
+		for(int sidx = 0; sidx < nstreams; sidx++)
+			p->chunks[idx].data[sidx] = (double*)calloc(chunk_len*vsize, sizeof(double));
+	}
+	pthread_mutex_init(&p->lock, NULL);
+	pthread_cond_init(&p->changed, NULL);
+	pthread_create(&p->loader, NULL, cln_pipeline_loader, p);
+	return p;
+}
+
+/* get the next chunk to train on, NULL at the end of a pass */
+cln_chunk* cln_pipeline_next(cln_pipeline* p)
+{
+	pthread_mutex_lock(&p->lock);
+	/* hand the previously consumed chunk back to the loader */
+	cln_chunk* prev = &p->chunks[p->use_idx ^ 1];
+	if(prev->state == CHUNK_IN_USE){
+		prev->state = CHUNK_FREE;
+		pthread_cond_broadcast(&p->changed);
+	}
+	cln_chunk* c = &p->chunks[p->use_idx];
+	double t0 = cln_now();
+	while(c->state != CHUNK_READY)
+		pthread_cond_wait(&p->changed, &p->lock);
+	p->use_stall += cln_now() - t0;
+	p->use_idx ^= 1;
+	if(c->len == 0){
+		/* end of pass marker */
+		c->state = CHUNK_FREE;
+		pthread_cond_broadcast(&p->changed);
+		c = NULL;
+	}
+	else{
+		c->state = CHUNK_IN_USE;
+	}
+	pthread_mutex_unlock(&p->lock);
+	return c;
+}
+
+/* stop the loader, report the stall times and release the pipeline */
+void cln_destroy_pipeline(cln_pipeline* p)
+{
+	pthread_mutex_lock(&p->lock);
+	p->stop = 1;
+	pthread_cond_broadcast(&p->changed);
+	pthread_mutex_unlock(&p->lock);
+	pthread_join(p->loader, NULL);
+	CLN_LOG("cln_destroy_pipeline: Loaded %ld samples, loader stalled %.3lf ms, trainer stalled %.3lf ms.\n",
+	        p->loaded, p->load_stall*1e3, p->use_stall*1e3);
+	p->src.close(p->src.ctx);
+	for(int idx = 0; idx < 2; idx++){
+		for(int sidx = 0; sidx < p->nstreams; sidx++)
+			free(p->chunks[idx].data[sidx]);
+		free(p->chunks[idx].data);
+	}
+	pthread_mutex_destroy(&p->lock);
+	pthread_cond_destroy(&p->changed);
+	free(p);
+}
@@ -0,0 +1,74 @@
+/*
+   Unsupervised correlation learning network using self-organizing maps
+
+        Each sensor projects onto a SOM network which will encode
+        the sensory afferent into neural activity. Depending on the
+        global network connectivity (1, 2, 3, ..., N sensory vars)
+        each SOM connects to other SOMs associated with other sensory
+        variables.
+
+        Simple scenario with 2 variables, representing sensory data.
+
+        Double buffered input pipeline.
+
+        A loader thread fills one chunk of samples (one vector per som
+        input stream) while the training loop consumes the other one. The
+        source is rewound at the end of each pass, so the first chunk of
+        the next epoch is loaded while the current one is trained on.
+*/
+
+#ifndef CLN_PIPELINE_H
+#define CLN_PIPELINE_H
+
+#include <pthread.h>
+#include "data.h"
+
+/* sample of a stream in a chunk */
+#define CLN_CHUNK_SAMPLE(c, s, i) (&(c)->data[(s)][(i)*(c)->vsize])
+
+/* input source - fill up to len samples per stream, 0 at the end of a pass */
+typedef struct{
+	int (*fill)(void* ctx, double** data, int nstreams, int vsize, int len);	// read the next samples
+	void (*rewind)(void* ctx);							// restart a pass
+	void (*close)(void* ctx);							// release the source
+	void* ctx;									// source state
+}cln_source;
+
+/* chunk of samples */
+typedef struct{
+	int len;		// samples in the chunk (0 marks the end of a pass)
+	int vsize;		// input vector size
+	double** data;		// samples of each stream, flat (len*vsize)
+	short state;		// buffer state
+}cln_chunk;
+
+/* input pipeline */
+typedef struct{
+	cln_source src;		// input source
+	int nstreams;		// number of input streams
+	int vsize;		// input vector size
+	int chunk_len;		// max samples per chunk
+	cln_chunk chunks[2];	// double buffer
+	int load_idx;		// buffer filled next by the loader
+	int use_idx;		// buffer consumed next by the trainer
+	int stop;		// loader shutdown request
+	double load_stall;	// time the loader waited for a free buffer (s)
+	double use_stall;	// time the trainer waited for a loaded buffer (s)
+	long loaded;		// samples loaded
+	pthread_mutex_t lock;	// buffers lock
+	pthread_cond_t changed;	// signals buffer state changes
+	pthread_t loader;	// loader thread
+}cln_pipeline;
+
+/* source iterating over in memory datasets, one per stream */
+cln_source cln_dataset_source(indataset** ind, int nstreams);
+/* source streaming sensor logs, stream s reads vsize columns from cols[s] */
+cln_source cln_sensor_file_source(char* data_file, int* cols, int nstreams);
+/* start the pipeline loading chunks of chunk_len samples */
+cln_pipeline* cln_create_pipeline(cln_source src, int nstreams, int vsize, int chunk_len);
+/* get the next chunk to train on, NULL at the end of a pass */
+cln_chunk* cln_pipeline_next(cln_pipeline* p);
+/* stop the loader, report the stall times and release the pipeline */
+void cln_destroy_pipeline(cln_pipeline* p);
+
+#endif
@@ -0,0 +1,206 @@
+/*
+   Unsupervised correlation learning network using self-organizing maps
+
+        Each sensor projects onto a SOM network which will encode
+        the sensory afferent into neural activity. Depending on the
+        global network connectivity (1, 2, 3, ..., N sensory vars)
+        each SOM connects to other SOMs associated with other sensory
+        variables.
+
+        Simple scenario with 2 variables, representing sensory data.
+
+        Model publication in POSIX shared memory for local reader processes.
+*/
+
+#include "publish.h"
+
+/* slot holding the latest complete model for a sequence value */
+static int cln_shm_stable_slot(unsigned long seq)
+{
+	/* while a slot is written (odd seq) the previous one stays valid */
+	return (int)(((seq & ~1UL)/2) % CLN_SHM_SLOTS);
+}
+
+/* create the shared memory segment for the given soms */
+cln_publisher* cln_create_publisher(const char* name, som** soms, int nsoms)
+{
+	CLN_LOG("cln_create_publisher: Creating shared model %s ...\n", name);
+	if(nsoms > CLN_SHM_MAX_SOMS){
+		printf("cln_create_publisher: Cannot publish more than %d soms.\n", CLN_SHM_MAX_SOMS);
+		return NULL;
+	}
+	/* every publication would copy the whole weights file */
+	if(cln_any_mapped_link(soms, nsoms)){
+		printf("cln_create_publisher: Mapped cross-modal weights are not published, publication disabled.\n");
+		return NULL;
+	}
+	/* compute the layout of a slot */
+	cln_link* links[CLN_SHM_MAX_SOMS];
+	int nlinks = cln_collect_links(soms, nsoms, links, CLN_SHM_MAX_SOMS);
+	size_t slot_size = 0;
+	size_t slot_off = (sizeof(cln_shm_header) + sizeof(double) - 1)/sizeof(double)*sizeof(double);
+	/* a kept segment may still be mapped by readers of the previous run, leave it to them */
+	shm_unlink(name);
+	int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+	if(fd < 0){
+		printf("cln_create_publisher: Cannot create shared memory object %s.\n", name);
+		return NULL;
+	}
+	for(int idx = 0; idx < nsoms; idx++){
+		size_t nn = soms[idx]->xsize*soms[idx]->ysize;
+		slot_size += nn*soms[idx]->insize*sizeof(double);
+	}
+	for(int idx = 0; idx < nlinks; idx++)
+		slot_size += (size_t)links[idx]->ns*links[idx]->nd*sizeof(double);
+	size_t size = slot_off + CLN_SHM_SLOTS*slot_size;
+	if(ftruncate(fd, size) < 0){
+		printf("cln_create_publisher: Cannot size shared memory object %s.\n", name);
+		close(fd);
+		return NULL;
+	}
+	cln_shm_header* hdr = (cln_shm_header*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(hdr == MAP_FAILED){
+		printf("cln_create_publisher: Cannot map shared memory object %s.\n", name);
+		return NULL;
+	}
+	/* describe the soms layout in the segment, hidden from readers until tagged */
+	__atomic_store_n(&hdr->magic, 0, __ATOMIC_RELEASE);
+	hdr->nsoms = nsoms;
+	hdr->nlinks = nlinks;
+	hdr->slot_off = slot_off;
+	hdr->slot_size = slot_size;
+	hdr->seq = 0;
+	size_t off = 0;
+	for(int idx = 0; idx < nsoms; idx++){
+		size_t nn = soms[idx]->xsize*soms[idx]->ysize;
+		hdr->soms[idx].id = soms[idx]->id;
+		hdr->soms[idx].xsize = soms[idx]->xsize;
+		hdr->soms[idx].ysize = soms[idx]->ysize;
+		hdr->soms[idx].insize = soms[idx]->insize;
+		hdr->soms[idx].w_off = off;
+		off += nn*soms[idx]->insize*sizeof(double);
+	}
+	for(int idx = 0; idx < nlinks; idx++){
+		hdr->links[idx].s_id = links[idx]->s->id;
+		hdr->links[idx].d_id = links[idx]->d->id;
+		hdr->links[idx].ns = links[idx]->ns;
+		hdr->links[idx].nd = links[idx]->nd;
+		hdr->links[idx].h_off = off;
+		off += (size_t)links[idx]->ns*links[idx]->nd*sizeof(double);
+	}
+	/* readers check the tag before trusting the layout */
+	__atomic_store_n(&hdr->magic, CLN_SHM_MAGIC, __ATOMIC_RELEASE);
+	cln_publisher* p = (cln_publisher*)calloc(1, sizeof(cln_publisher));
+	p->name = strdup(name);
+	p->soms = soms;
+	memcpy(p->links, links, nlinks*sizeof(cln_link*));
+	p->hdr = hdr;
+	p->size = size;
+	CLN_LOG("cln_create_publisher: Shared model %s uses %zu bytes.\n", name, size);
+	return p;
+}
+
+/* publish a snapshot of the soms weights without blocking readers */
+void cln_publish_model(cln_publisher* p, int epoch)
+{
+	cln_shm_header* hdr = p->hdr;
+	unsigned long seq = hdr->seq;
+	/* write the slot readers are not using */
+	int slot = (cln_shm_stable_slot(seq) + 1) % CLN_SHM_SLOTS;
+	char* base = (char*)hdr + hdr->slot_off + slot*hdr->slot_size;
+	__atomic_store_n(&hdr->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	for(int idx = 0; idx < hdr->nsoms; idx++){
+		som* s = p->soms[idx];
+		memcpy(base + hdr->soms[idx].w_off, s->neurons[0][0].W, s->xsize*s->ysize*s->insize*sizeof(double));
+	}
+	for(int idx = 0; idx < hdr->nlinks; idx++){
+		cln_link* l = p->links[idx];
+		memcpy(base + hdr->links[idx].h_off, l->H, (size_t)l->ns*l->nd*sizeof(double));
+	}
+	hdr->epoch[slot] = epoch;
+	/* make the new slot the stable one */
+	__atomic_store_n(&hdr->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/* unmap the shared memory segment, remove it unless keep is set */
+void cln_destroy_publisher(cln_publisher* p, int keep)
+{
+	munmap(p->hdr, p->size);
+	if(keep)
+		CLN_LOG("cln_destroy_publisher: Kept shared model %s for readers.\n", p->name);
+	else{
+		shm_unlink(p->name);
+		CLN_LOG("cln_destroy_publisher: Removed shared model %s.\n", p->name);
+	}
+	free(p->name);
+	free(p);
+}
+
+/* map a published model for reading */
+cln_subscriber* cln_open_subscriber(const char* name)
+{
+	struct stat st;
+	int fd = shm_open(name, O_RDONLY, 0);
+	if(fd < 0){
+		printf("cln_open_subscriber: Cannot open shared memory object %s.\n", name);
+		return NULL;
+	}
+	if(fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(cln_shm_header)){
+		printf("cln_open_subscriber: Shared memory object %s is not a model.\n", name);
+		close(fd);
+		return NULL;
+	}
+	cln_shm_header* hdr = (cln_shm_header*)mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(hdr == MAP_FAILED){
+		printf("cln_open_subscriber: Cannot map shared memory object %s.\n", name);
+		return NULL;
+	}
+	if(__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) != CLN_SHM_MAGIC ||
+	   hdr->nsoms > CLN_SHM_MAX_SOMS || hdr->nlinks > CLN_SHM_MAX_SOMS ||
+	   hdr->slot_off + CLN_SHM_SLOTS*hdr->slot_size > (size_t)st.st_size){
+		printf("cln_open_subscriber: Shared memory object %s is not a model.\n", name);
+		munmap(hdr, st.st_size);
+		return NULL;
+	}
+	cln_subscriber* s = (cln_subscriber*)calloc(1, sizeof(cln_subscriber));
+	s->hdr = hdr;
+	s->size = st.st_size;
+	return s;
+}
+
+/* get a view of the latest model, returns the sequence to validate the view with, 0 and no view before the first model */
+unsigned long cln_read_begin(cln_subscriber* s, cln_shm_view* v)
+{
+	const cln_shm_header* hdr = s->hdr;
+	unsigned long seq = __atomic_load_n(&hdr->seq, __ATOMIC_ACQUIRE);
+	memset(v, 0, sizeof(cln_shm_view));
+	/* the first model is complete once seq reaches 2 */
+	if(seq < 2)
+		return 0;
+	int slot = cln_shm_stable_slot(seq);
+	const char* base = (const char*)hdr + hdr->slot_off + slot*hdr->slot_size;
+	v->epoch = hdr->epoch[slot];
+	for(int idx = 0; idx < hdr->nsoms; idx++)
+		v->W[idx] = (const double*)(base + hdr->soms[idx].w_off);
+	for(int idx = 0; idx < hdr->nlinks; idx++)
+		v->H[idx] = (const double*)(base + hdr->links[idx].h_off);
+	return seq;
+}
+
+/* check that the view obtained at seq was not overwritten while in use */
+int cln_read_validate(cln_subscriber* s, unsigned long seq)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	/* the viewed slot is rewritten only once the writer moved two publications ahead */
+	return __atomic_load_n(&s->hdr->seq, __ATOMIC_RELAXED) <= (seq & ~1UL) + 2;
+}
+
+/* unmap a published model */
+void cln_close_subscriber(cln_subscriber* s)
+{
+	munmap(s->hdr, s->size);
+	free(s);
+}
@@ -0,0 +1,108 @@
+/*
+   Unsupervised correlation learning network using self-organizing maps
+
+        Each sensor projects onto a SOM network which will encode
+        the sensory afferent into neural activity. Depending on the
+        global network connectivity (1, 2, 3, ..., N sensory vars)
+        each SOM connects to other SOMs associated with other sensory
+        variables.
+
+        Simple scenario with 2 variables, representing sensory data.
+
+        Model publication in POSIX shared memory for local reader processes.
+
+        The segment holds a header, one descriptor per SOM and per link and
+        two model slots. Each link stores its cross-modal weights once, row
+        major with the s som on the rows, as the link keeps them. The
+        trainer always writes the slot readers are not using and flips the
+        sequence counter when done (seqlock over a double buffer), so it
+        never waits for readers and readers never see a torn model.
+
+        The segment can outlive the trainer so readers still find the final
+        model. Once it is removed, readers that already mapped it keep their
+        mapping but new readers cannot open it. A new trainer always removes
+        the previous segment and creates a fresh one, so readers still
+        mapped to the old model never see it rewritten or resized.
+*/
+
+#ifndef CLN_PUBLISH_H
+#define CLN_PUBLISH_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "link.h"
+
+#define CLN_SHM_MAGIC	0x434c4e4dU	// "CLNM"
+#define CLN_SHM_SLOTS	2		// double buffered model
+#define CLN_SHM_MAX_SOMS	8		// max number of soms in a published model
+
+/* published SOM layout */
+typedef struct{
+	short id;		// id of the network
+	short xsize;		// size of the network x dimension
+	short ysize;		// size of the network y dimension
+	short insize;		// input vector size
+	size_t w_off;		// sensory weights offset in a slot (bytes)
+}cln_shm_som;
+
+/* published link layout */
+typedef struct{
+	short s_id;		// id of the som on the rows
+	short d_id;		// id of the som on the columns
+	int ns;			// number of rows
+	int nd;			// number of columns
+	size_t h_off;		// cross-modal weights offset in a slot (bytes)
+}cln_shm_link;
+
+/* shared memory segment header */
+typedef struct{
+	unsigned int magic;	// segment tag
+	int nsoms;		// number of published soms
+	int nlinks;		// number of published links
+	size_t slot_off;	// first slot offset in the segment (bytes)
+	size_t slot_size;	// size of a slot (bytes)
+	unsigned long seq;	// publication counter, odd while a slot is written, 0 before the first model
+	int epoch[CLN_SHM_SLOTS];	// training epoch of the model in each slot
+	cln_shm_som soms[CLN_SHM_MAX_SOMS];	// published soms layout
+	cln_shm_link links[CLN_SHM_MAX_SOMS];	// published links layout
+}cln_shm_header;
+
+/* trainer side of a published model */
+typedef struct{
+	char* name;		// shared memory object name
+	som** soms;		// published soms
+	cln_link* links[CLN_SHM_MAX_SOMS];	// published links
+	cln_shm_header* hdr;	// mapped segment
+	size_t size;		// mapped segment size
+}cln_publisher;
+
+/* reader side of a published model */
+typedef struct{
+	cln_shm_header* hdr;	// mapped segment (read only)
+	size_t size;		// mapped segment size
+}cln_subscriber;
+
+/* consistent model view, valid until cln_read_validate fails */
+typedef struct{
+	int epoch;		// training epoch of the model
+	const double* W[CLN_SHM_MAX_SOMS];	// sensory weights of each som, flat (xsize*ysize*insize)
+	const double* H[CLN_SHM_MAX_SOMS];	// cross-modal weights of each link, flat (ns*nd)
+}cln_shm_view;
+
+/* create the shared memory segment for the given soms */
+cln_publisher* cln_create_publisher(const char* name, som** soms, int nsoms);
+/* publish a snapshot of the soms weights without blocking readers */
+void cln_publish_model(cln_publisher* p, int epoch);
+/* unmap the shared memory segment, remove it unless keep is set */
+void cln_destroy_publisher(cln_publisher* p, int keep);
+/* map a published model for reading */
+cln_subscriber* cln_open_subscriber(const char* name);
+/* get a view of the latest model, returns the sequence to validate the view with, 0 and no view before the first model */
+unsigned long cln_read_begin(cln_subscriber* s, cln_shm_view* v);
+/* check that the view obtained at seq was not overwritten while in use */
+int cln_read_validate(cln_subscriber* s, unsigned long seq);
+/* unmap a published model */
+void cln_close_subscriber(cln_subscriber* s);
+
+#endif
@@ -45,14 +45,24 @@ simopts* cln_setup_simulation(short ut, double ai, double si, double gi, double
 	return so;
 }
 
+/* release simulation params */
+void cln_destroy_simulation(simopts* so)
+{
+	free(so->alpha);
+	free(so->sigma);
+	free(so->gamma);
+	free(so->xi);
+	free(so->kappa);
+	free(so);
+}
+
 /* return simulation parameters after runtime */
 simopts* cln_get_simulation_params(simopts* in)
 {
 	/*
 	printf("cln_get_simulation_params: Getting current value of simulation params...\n");
 	*/
-	simopts* simout = (simopts*)calloc(1, sizeof(simopts));
-	simout = in;
+	simopts* simout = in;
 	/*
 	printf("cln_get_simulation_params: Simulation params after runtime are saved.\n");
 	*/
@@ -68,3 +78,64 @@ void cln_set_simulation_params(simopts* so, int iter, double ai, double si, doub
 	*/
 }
 
+/* set the params of epoch iter from their initial values, adaptive params decay with the time constant tau */
+void cln_schedule_simulation_params(simopts* so, int iter, double ai, double si, double gi, double xii, double ki, double tau)
+{
+	if(so->paramsupdate==ADAPTIVE_PARAMS){
+		cln_set_simulation_params(so, iter,
+					  ai*exp(-(double)iter/tau),
+					  si*exp(-(double)iter/so->lambda),
+					  gi*exp((double)iter/tau),
+					  xii*exp((double)iter/tau),
+					  ki*exp((double)iter/tau));
+	}
+	else{
+		cln_set_simulation_params(so, iter, ai, si*exp(-(double)iter/so->lambda), gi, xii, ki);
+	}
+}
+
+/* stop training once each convergence metric changes less than tol for patience epochs, counted once sigma decayed to decay times its initial value */
+void cln_set_early_stopping(simopts* so, int patience, double tol, double decay)
+{
+	so->es_patience = patience;
+	so->es_tolerance = tol;
+	so->es_decay = decay;
+	memset(so->es_prev, 0, sizeof(so->es_prev));
+	so->es_wait = 0;
+}
+
+/* check the epoch metrics of the soms for a plateau, shrinks the epoch budget and returns 1 to stop */
+int cln_check_convergence(simopts* so, som** soms, int nsoms)
+{
+	/* monitor quantization error, topographic error and cross-modal weights change, each on its own scale */
+	double cur[3] = {0.0f, 0.0f, 0.0f};
+	for(int idx = 0; idx < nsoms; idx++){
+		cln_metrics* m = &soms[idx]->metrics;
+		if(m->nsamples){
+			cur[0] += m->qe/m->nsamples;
+			cur[1] += (double)m->te/m->nsamples;
+		}
+		if(m->nupdates)
+			cur[2] += sqrt(m->dh/m->nupdates);
+		cln_reset_metrics(soms[idx]);
+	}
+	if(so->es_patience <= 0)
+		return 0;
+	/* a plateau needs every metric settled, the largest one would hide the others in a sum */
+	int settled = 1;
+	for(int idx = 0; idx < 3; idx++){
+		settled &= fabs(cur[idx] - so->es_prev[idx]) <= so->es_tolerance*fabs(so->es_prev[idx]);
+		so->es_prev[idx] = cur[idx];
+	}
+	/* the maps keep moving while the neighborhood shrinks, plateaus before are transient */
+	if(settled && so->sigma[so->cur_epoch] <= so->es_decay*so->sigma[0])
+		so->es_wait++;
+	else
+		so->es_wait = 0;
+	if(so->es_wait < so->es_patience)
+		return 0;
+	/* shrink the epoch budget to the epochs actually trained */
+	CLN_LOG("cln_check_convergence: Metrics plateaued for %d epochs, stopping at epoch %d of %d.\n", so->es_wait, so->cur_epoch, so->simepochs);
+	so->simepochs = so->cur_epoch + 1;
+	return 1;
+}
@@ -12,12 +12,24 @@
         Simulation options and parameters for runtime.
 */
 
+#ifndef CLN_SIMULATION_H
+#define CLN_SIMULATION_H
+
 #include "som.h"
 
 /* init simulation params */
 simopts* cln_setup_simulation(short ut, double ai, double si, double gi, double xii, double ki, short src, int epochs, short learning_type);
+/* release simulation params */
+void cln_destroy_simulation(simopts* so);
 /* return simulation parameters after runtime */
 simopts* cln_get_simulation_params(simopts* in);
 /* set the current parameters in the simulation struct */
 void cln_set_simulation_params(simopts*so, int iter, double ai, double si, double gi, double xii, double ki);
+/* set the params of epoch iter from their initial values, adaptive params decay with the time constant tau */
+void cln_schedule_simulation_params(simopts* so, int iter, double ai, double si, double gi, double xii, double ki, double tau);
+/* stop training once each convergence metric changes less than tol for patience epochs, counted once sigma decayed to decay times its initial value */
+void cln_set_early_stopping(simopts* so, int patience, double tol, double decay);
+/* check the epoch metrics of the soms for a plateau, shrinks the epoch budget and returns 1 to stop */
+int cln_check_convergence(simopts* so, som** soms, int nsoms);
 
+#endif
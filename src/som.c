@@ -13,21 +13,28 @@
 */
 
 #include "som.h"
+#include "kernels.h"
+#include "link.h"
 
 /* build a SOM network given input params */
 som* cln_create_som(short ni, short nszx, short nszy, short insz, double inmin, double inmax)
 {
 	/* init */	
-	printf("cln_create_som: Creating SOM%d with %dx%d neurons ...\n", ni, nszx, nszy);
+	CLN_LOG("cln_create_som: Creating SOM%d with %dx%d neurons ...\n", ni, nszx, nszy);
 	som* network = (som*)calloc(1, sizeof(som));
 	network->id = ni;
 	network->xsize = nszx;
 	network->ysize = nszy;
 	network->insize = insz;
+	network->inmin = inmin;
+	network->inmax = inmax;
+	/* the lattice and the sensory weights are single blocks so kernels can walk them flat */
 	network->neurons = (neuron**)calloc(network->xsize, sizeof(neuron*));
-	for(int idx = 0; idx < network->xsize; idx++){
-		network->neurons[idx] = (neuron*)calloc(network->ysize, sizeof(neuron));
+	network->neurons[0] = (neuron*)calloc(network->xsize*network->ysize, sizeof(neuron));
+	for(int idx = 1; idx < network->xsize; idx++){
+		network->neurons[idx] = network->neurons[0] + idx*network->ysize;
 	}	
+	double* wblock = (double*)calloc(network->xsize*network->ysize*insz, sizeof(double));
 	for(int idx = 0; idx < network->xsize; idx++){
 		for(int jdx = 0; jdx < network->ysize; jdx++){
 			network->neurons[idx][jdx].xpos = idx;
@@ -35,11 +42,7 @@ som* cln_create_som(short ni, short nszx, short nszy, short insz, double inmin,
 			network->neurons[idx][jdx].As = 0.0f;
 			network->neurons[idx][jdx].Ax = 0.0f;
 			network->neurons[idx][jdx].At = 0.0f;
-			network->neurons[idx][jdx].W = (double*)calloc(insz, sizeof(double));
-			network->neurons[idx][jdx].H = (double**)calloc(network->xsize, sizeof(double*));
-			for (int tdx = 0; tdx < network->xsize; tdx++){
-				network->neurons[idx][jdx].H[tdx] = (double*)calloc(network->ysize, sizeof(double));
-			}
+			network->neurons[idx][jdx].W = wblock + (idx*network->ysize + jdx)*insz;
 		}
 	}
 	for(int idx = 0; idx < network->xsize; idx++){
@@ -48,15 +51,12 @@ som* cln_create_som(short ni, short nszx, short nszy, short insz, double inmin,
 				/* randomly init sensory weights between min and max of input data to speed up convergence */
 				network->neurons[idx][jdx].W[in_idx] = inmin + ((double)rand()/(double)RAND_MAX)*(inmax - inmin);
 			}
-			for(int tdx = 0; tdx < network->xsize; tdx++){
-				for(int vdx = 0; vdx < network->ysize; vdx++){
-					/* randomly init cross-modal weights with small numbers */
-					network->neurons[idx][jdx].H[tdx][vdx] = (double)rand()/(double)RAND_MAX;
-				}
-			}
 		}
 	}
-	printf("cln_create_som: SOM%d was created and initialized.\n", network->id);
+	/* pick constant bound kernels if the shape is registered */
+	network->kernels = cln_select_kernels(network->xsize, network->ysize, network->insize);
+	CLN_LOG("cln_create_som: SOM%d uses %s kernels.\n", network->id, network->kernels == &cln_generic_kernels ? "generic" : "specialized");
+	CLN_LOG("cln_create_som: SOM%d was created and initialized.\n", network->id);
 	return network;
 }
 
@@ -64,16 +64,11 @@ som* cln_create_som(short ni, short nszx, short nszy, short insz, double inmin,
 void cln_destroy_som(som* som)
 {
 	/* deallocate resources */
-	for(int idx = 0;idx < som->xsize; idx++){
-		for(int jdx = 0; jdx < som->ysize; jdx++){
-	 		free(som->neurons[idx][jdx].W);
-			for(int tdx = 0; tdx < som->ysize; tdx++){
-				free(som->neurons[idx][jdx].H[tdx]);
-			}
-			free(som->neurons[idx][jdx].H);
-		}
-	}
-	printf("cln_destory_som: Freed SOM%d allocated resources.\n", som->id);
+	free(som->neurons[0][0].W);
+	free(som->neurons[0]);
+	free(som->neurons);
+	CLN_LOG("cln_destory_som: Freed SOM%d allocated resources.\n", som->id);
+	free(som);
 }
 
 /* display the SOM network details */
@@ -92,11 +87,13 @@ void cln_display_som(som* som)
 		printf("\n \n");
 	}
 	printf("\n SYNAPTIC WEIGHTS - CROSS MODAL LINKS \n \n");
-	for(int idx = 0; idx < som->ysize; idx++){
+	if(som->link && som->link->mapped)
+		printf(" %dx%d weights mapped from a file, not displayed \n \n", som->link->ns, som->link->nd);
+	for(int idx = 0; som->link && !som->link->mapped && idx < som->ysize; idx++){
 		for(int in_idx = 0; in_idx<som->xsize; in_idx++){
 			for(int jdx = 0; jdx<som->ysize; jdx++){
 				for(int in_jdx = 0; in_jdx < som->xsize; in_jdx++){
-					printf(" %lf ", som->neurons[idx][jdx].H[in_idx][in_jdx]);
+					printf(" %lf ", cln_link_weight(som->link, som, idx*som->ysize + jdx, in_idx*som->ysize + in_jdx));
 				}
 				printf("\t");
 			}
@@ -128,64 +125,65 @@ void cln_display_som(som* som)
 	printf("\n");
 }
 
-/* find the sensory elicited winner neuron */
-neuron* cln_find_sensory_bmu(som* som, double* vin)
+/* find the sensory elicited winner neuron - generic kernel */
+static neuron* cln_generic_sensory_bmu(som* som, double* vin)
 {
 	/* the winner neuron after projecting the sensory data */
-	neuron* bmu = (neuron*)calloc(1, sizeof(neuron));
+	neuron* bmu = &som->neurons[0][0];
+	/* runner-up neuron for the topographic error */
+	neuron* second = bmu;
 	/* max quantization error */
 	double max_qe = DBL_MAX;
+	double second_qe = DBL_MAX;
 	double cur_qe = 0.0f;
 	/* find the bmu in the som */
 	for(int idx=0; idx<som->xsize; idx++){
 		for (int jdx = 0;jdx<som->ysize;jdx++){
 			/* the winner is the neuron which minimizes the Euclidian distance to the input */
 			if((cur_qe = cln_compute_norm(vin, som->neurons[idx][jdx].W, som->insize))<max_qe){
+				second_qe = max_qe;
+				second = bmu;
 				max_qe = cur_qe;
-				bmu->xpos = idx;
-				bmu->ypos = jdx;
+				bmu = &som->neurons[idx][jdx];
+			}
+			else if(cur_qe<second_qe){
+				second_qe = cur_qe;
+				second = &som->neurons[idx][jdx];
 			}
 		}
 	}
+	/* convergence metrics as a by-product of the search */
+	som->metrics.qe += max_qe;
+	som->metrics.te += abs(bmu->xpos - second->xpos)>1 || abs(bmu->ypos - second->ypos)>1;
+	som->metrics.nsamples++;
 	return bmu;
 }
 
 /* find the cross-modal elicited winner neuron */
 neuron* cln_find_xmodal_bmu(som* src_som, som* dest_som)
 {
-	/* cross modal projection winner neurnon */
-	neuron* bmu = (neuron*)calloc(1,sizeof(neuron));
-	/* global cross modal activation from source to target network */
-	double** xmod_act = (double**) calloc(dest_som->xsize, sizeof(double*));
-	for(int i=0; i<dest_som->xsize; i++)
-		xmod_act[i] = (double*)calloc(dest_som->ysize, sizeof(double));
+	cln_link* l = src_som->link;
+	const neuron* ns = src_som->neurons[0];
+	int nns = src_som->xsize*src_som->ysize, nnd = dest_som->xsize*dest_som->ysize;
 	/* maximally activated neuron activation */
 	double max_xmod_act = 0.0f;
-	/* compute activation from source network to target network and check winner (maximizes the activation) */
-	for(int idx = 0; idx<dest_som->xsize; idx++){
-		for(int jdx=0;jdx<dest_som->ysize; jdx++){
-			for (int tdx = 0; tdx<src_som->xsize; tdx++){
-				for(int sdx = 0; sdx<src_som->ysize; sdx++){
-					xmod_act[idx][jdx]+=src_som->neurons[tdx][sdx].As*src_som->neurons[tdx][sdx].H[idx][jdx];
-				}
-			}
-		}
-	}
+	int win = 0;
+	/* compute activation from source network to target network through the link view of the source */
+	for(int idx = 0; idx < nns; idx++)
+		l->act[idx] = ns[idx].As;
+	cln_link_project(l, src_som, l->act, l->xact);
 	/* find the neuron which is closer to the maximum cross activation */
-	for (int ridx = 0;ridx<dest_som->xsize; ridx ++){
-		for (int cidx = 0; cidx<dest_som->ysize; cidx++){
-			if(xmod_act[ridx][cidx]>max_xmod_act){
-				max_xmod_act = xmod_act[ridx][cidx];
-				bmu->xpos = ridx;
-				bmu->ypos = cidx;
-			}
+	for(int idx = 0; idx < nnd; idx++){
+		if(l->xact[idx]>max_xmod_act){
+			max_xmod_act = l->xact[idx];
+			win = idx;
 		}
 	}
-	return bmu;
+	return &dest_som->neurons[0][win];
 }
 
-/* compute forward activation - sensory afferents elicited activation */
-void cln_compute_sensory_activation(som* s, neuron* bmu)
+/* compute forward activation - sensory afferents elicited activation - generic kernel */
+static void cln_generic_sensory_activation(som* s, neuron* bmu)
 {	
 	double win_val[2] = {bmu->xpos, bmu->ypos};
 	double cur_val[2] = {0,0};
@@ -197,8 +195,8 @@ void cln_compute_sensory_activation(som* s, neuron* bmu)
 	}
 }
 
-/* compute indirect activation - cross-modal elicited activation */
-void cln_compute_xmodal_activation(som* s, neuron* bmu)
+/* compute indirect activation - cross-modal elicited activation - generic kernel */
+static void cln_generic_xmodal_activation(som* s, neuron* bmu)
 {
 	double win_val[2] = {bmu->xpos, bmu->ypos};
 	double cur_val[2] = {0,0};
@@ -210,8 +208,8 @@ void cln_compute_xmodal_activation(som* s, neuron* bmu)
 	}
 }
 
-/* comute the joint activation as a weighted sum of direct and indirect activations */
-void cln_compute_joint_activation(som*s)
+/* comute the joint activation as a weighted sum of direct and indirect activations - generic kernel */
+static void cln_generic_joint_activation(som*s)
 {
 	for (int idx=0; idx<s->xsize; idx++){
 		for(int jdx =0; jdx<s->ysize;jdx++){
@@ -221,86 +219,116 @@ void cln_compute_joint_activation(som*s)
 	}
 }
 
-/* adapt the sensory projecton weights */
-void cln_compute_sensory_weights(som* s, double* inp)
+/* adapt the sensory projecton weights - generic kernel */
+static void cln_generic_sensory_weights(som* s, double* inp)
 {
 	 for (int idx=0; idx<s->xsize; idx++){
                 for(int jdx =0; jdx<s->ysize;jdx++){
 			for(int widx = 0; widx<s->insize; widx++)
-	                        s->neurons[idx][jdx].W[widx] += s->params->alpha[s->params->cur_epoch]*s->neurons[idx][jdx].At*(inp[idx]-s->neurons[idx][jdx].W[widx]) - 
-								s->params->xi[s->params->cur_epoch]*(s->neurons[idx][jdx].As - s->neurons[idx][jdx].At)*(inp[idx]-s->neurons[idx][jdx].W[widx]);
+	                        s->neurons[idx][jdx].W[widx] += s->params->alpha[s->params->cur_epoch]*s->neurons[idx][jdx].At*(inp[widx]-s->neurons[idx][jdx].W[widx]) - 
+								s->params->xi[s->params->cur_epoch]*(s->neurons[idx][jdx].As - s->neurons[idx][jdx].At)*(inp[widx]-s->neurons[idx][jdx].W[widx]);
                 }
         }
 }
 
-/* adapt the cross-modal hebbian links */
+/* runtime bound kernels, valid for any lattice shape */
+const cln_kernels cln_generic_kernels = {
+	0, 0, 0,
+	cln_generic_sensory_bmu,
+	cln_generic_sensory_activation,
+	cln_generic_xmodal_activation,
+	cln_generic_joint_activation,
+	cln_generic_sensory_weights
+};
+
+/* find the sensory elicited winner neuron */
+neuron* cln_find_sensory_bmu(som* som, double* vin)
+{
+	return som->kernels->sensory_bmu(som, vin);
+}
+
+/* compute forward activation - sensory afferents elicited activation */
+void cln_compute_sensory_activation(som* s, neuron* bmu)
+{
+	s->kernels->sensory_activation(s, bmu);
+}
+
+/* compute indirect activation - cross-modal elicited activation */
+void cln_compute_xmodal_activation(som* s, neuron* bmu)
+{
+	s->kernels->xmodal_activation(s, bmu);
+}
+
+/* comute the joint activation as a weighted sum of direct and indirect activations */
+void cln_compute_joint_activation(som* s)
+{
+	s->kernels->joint_activation(s);
+}
+
+/* adapt the sensory projecton weights */
+void cln_compute_sensory_weights(som* s, double* inp)
+{
+	s->kernels->sensory_weights(s, inp);
+}
+
+/* adapt the cross-modal hebbian links shared by s and d */
 void cln_compute_xmodal_weights(som* s, som* d)
 {
-	 double meanAts = 0.0f, meanAtd = 0.0f;
-	 for (int idx=0; idx<s->xsize; idx++){
-                for(int jdx =0; jdx<s->ysize;jdx++){
-			for(int hidx = 0; hidx<s->xsize; hidx++){
-				for(int hjdx = 0; hjdx<s->ysize; hjdx++){
-					switch(s->params->learn_rule){
-       						case(NONE):
-							s->neurons[hidx][hjdx].H[idx][jdx] = 0.0f;
-							d->neurons[hidx][hjdx].H[idx][jdx] = 0.0f;			
-                				break;
-                				case (HEBBIAN):
-							s->neurons[hidx][hjdx].H[idx][jdx] = s->params->kappa[s->params->cur_epoch]*s->neurons[hidx][hjdx].At*d->neurons[idx][jdx].At;
-                                                        d->neurons[hidx][hjdx].H[idx][jdx] = s->params->kappa[s->params->cur_epoch]*d->neurons[hidx][hjdx].At*s->neurons[idx][jdx].At;
-                				break;
-        				        case(COVARIANCE):
-							/* compute the mean activation at the source and destination map */
-							for (int midx=0; midx<s->xsize; midx++){
-						                for(int mjdx =0; mjdx<s->ysize;mjdx++){							
-									meanAts += s->neurons[midx][mjdx].At;
-									meanAtd += d->neurons[midx][mjdx].At;
-								}
-							}
-							meanAts /= s->xsize*s->ysize;
-							meanAtd /= d->xsize*d->ysize;
-							s->neurons[hidx][hjdx].H[idx][jdx] = s->params->kappa[s->params->cur_epoch]*(s->neurons[hidx][hjdx].At - meanAts)*
-																    (d->neurons[idx][jdx].At - meanAtd);
-							d->neurons[hidx][hjdx].H[idx][jdx] = s->params->kappa[s->params->cur_epoch]*(d->neurons[hidx][hjdx].At - meanAtd)*
-																    (s->neurons[idx][jdx].At - meanAts);
+	(void)d;
+	/* both views are updated at once through the shared link */
+	cln_update_link(s->link, s->params);
+}
 
-                				break;		
-         				}
-				}
-			}
+/* infer the dst input from a src input through the cross-modal links, leaves the soms untouched
+   scratch holds src and dst lattice sized activations, returns the dst winner index */
+int cln_recall(som* src, som* dst, double* in, double* out, double* scratch)
+{
+	const neuron* ns = src->neurons[0];
+	int nns = src->xsize*src->ysize;
+	double min_qe = DBL_MAX, cur_qe = 0.0f;
+	int win = 0;
+	/* sensory winner in the source som */
+	for(int idx = 0; idx < nns; idx++){
+		if((cur_qe = cln_compute_norm(in, ns[idx].W, src->insize)) < min_qe){
+			min_qe = cur_qe;
+			win = idx;
 		}
 	}
-	/* normalize weights */
-	/* fin min and max in the weight matrices */
-	double minHs = DBL_MAX, minHd = DBL_MAX;
-	double maxHs = 0.0f, maxHd = 0.0f;
-	for (int idx = 0; idx<s->xsize; idx++){
-		for(int jdx=0; jdx<s->ysize; jdx++){
-			for (int hidx = 0; hidx<s->xsize; hidx++){
-				for(int hjdx = 0; hjdx<s->ysize; hjdx++){
-					if(s->neurons[idx][jdx].H[hidx][hjdx] < minHs)
-						minHs = s->neurons[idx][jdx].H[hidx][hjdx];
-					if(s->neurons[idx][jdx].H[hidx][hjdx] > maxHs)
-						maxHs = s->neurons[idx][jdx].H[hidx][hjdx];
-					if(d->neurons[idx][jdx].H[hidx][hjdx] < minHd)
-						minHd = d->neurons[idx][jdx].H[hidx][hjdx];
-					if(d->neurons[idx][jdx].H[hidx][hjdx] > maxHd)
-						maxHd = d->neurons[idx][jdx].H[hidx][hjdx];	
-				}
-			}
-		}
+	return cln_recall_winner(src, dst, win, out, scratch);
+}
+
+/* recall from a given src sensory winner, the rest of cln_recall */
+int cln_recall_winner(som* src, som* dst, int win, double* out, double* scratch)
+{
+	const neuron* ns = src->neurons[0];
+	const neuron* nd = dst->neurons[0];
+	int nns = src->xsize*src->ysize, nnd = dst->xsize*dst->ysize;
+	double* act = scratch;
+	double* xact = scratch + nns;
+	double max_xact = 0.0f;
+	int xwin = 0;
+	/* sensory elicited activity around the winner */
+	double win_val[2] = {ns[win].xpos, ns[win].ypos};
+	double cur_val[2] = {0,0};
+	for(int idx = 0; idx < nns; idx++){
+		cur_val[0] = ns[idx].xpos; cur_val[1] = ns[idx].ypos;
+		act[idx] = exp(-pow(cln_compute_norm(win_val, cur_val, 2), 2)/(2*pow(src->params->sigma[src->params->cur_epoch], 2)));
 	}
-	/* apply normalization */
-	for (int idx = 0; idx<s->xsize; idx++){
-                for(int jdx=0; jdx<s->ysize; jdx++){
-                        for (int hidx = 0; hidx<s->xsize; hidx++){
-                                for(int hjdx = 0; hjdx<s->ysize; hjdx++){
-					s->neurons[idx][jdx].H[hidx][hjdx] = (s->neurons[idx][jdx].H[hidx][hjdx] - minHs)/(maxHs - minHs);
-					d->neurons[idx][jdx].H[hidx][hjdx] = (d->neurons[idx][jdx].H[hidx][hjdx] - minHd)/(maxHd - minHd);
-				}
-			}
+	/* cross-modal projection and winner in the destination som */
+	cln_link_recall(src->link, src, act, xact);
+	for(int idx = 0; idx < nnd; idx++){
+		if(xact[idx] > max_xact){
+			max_xact = xact[idx];
+			xwin = idx;
 		}
 	}
+	/* decode the destination winner preferred input */
+	memcpy(out, nd[xwin].W, dst->insize*sizeof(double));
+	return xwin;
 }
 
+/* clear the accumulated convergence metrics */
+void cln_reset_metrics(som* s)
+{
+	memset(&s->metrics, 0, sizeof(cln_metrics));
+}
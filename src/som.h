@@ -12,10 +12,14 @@
 	SOM specific functionality
 */
 
+#ifndef CLN_SOM_H
+#define CLN_SOM_H
+
 #include <stdio.h>
 #include <stdlib.h> 
 #include <unistd.h>
 #include <float.h>
+#include <string.h>
 #include "tools.h"
 
 /* data source */
@@ -60,6 +64,11 @@ typedef struct{
         int simepochs;          // simulation epochs    
         int cur_epoch;          // current training epoch 
 	short learn_rule;	// type of learning rule for cross-modal interaction
+	int es_patience;	// plateaued epochs before stopping early (0 disables)
+	double es_tolerance;	// relative change of each metric still counted as a plateau
+	double es_decay;	// fraction of the initial neighborhood size below which plateaus are counted
+	double es_prev[3];	// quantization error, topographic error and cross-modal change of the previous epoch
+	int es_wait;		// consecutive plateaued epochs
 }simopts;
 
 /* SOM neuron */
@@ -67,12 +76,20 @@ typedef struct{
 	short xpos;	// x position in the SOM lattice 
 	short ypos;	// y position in the SOM lattice
 	double* W;	// sensory projections synaptic weights
-	double** H;	// cross modal synaptic weights
 	double As;	// sensory elicitied activity
 	double Ax;	// cross modal elicited activity
 	double At;	// total activity
 }neuron;
 
+/* convergence metrics, accumulated by the kernels */
+typedef struct{
+	double qe;	// summed distance of the inputs to their winner (quantization error)
+	long te;	// samples whose two best neurons are not lattice neighbours (topographic error)
+	long nsamples;	// samples accumulated in qe and te
+	double dh;	// summed mean squared change of the cross-modal weights
+	long nupdates;	// cross-modal updates accumulated in dh
+}cln_metrics;
+
 /* SOM network */
 typedef struct{
 	/* structure */
@@ -80,8 +97,13 @@ typedef struct{
 	short xsize; 	// size of the network x dimension
 	short ysize;	// size of the network y dimension
 	short insize;	// input vector size
-	neuron** neurons;	// the neurons lattice
+	double inmin;	// lower bound of the input domain
+	double inmax;	// upper bound of the input domain
+	neuron** neurons;	// the neurons lattice (row major, one contiguous block)
 	simopts* params;// parameters for simulation for som
+	const struct cln_kernels* kernels; // compute kernels selected for the lattice shape
+	struct cln_link* link;	// cross-modal link holding the cross modal synaptic weights
+	cln_metrics metrics;	// convergence metrics since the last reset
 }som;
 
 /* build a SOM network given input params */
@@ -90,7 +112,7 @@ som* cln_create_som(short nid, short nszx, short nszy, short insz, double inmin,
 void cln_destroy_som(som* som);
 /* display the SOM network details */
 void cln_display_som(som* som);
-/* find the sensory elicited winner neuron */
+/* find the sensory elicited winner neuron (returns the winner in the lattice) */
 neuron* cln_find_sensory_bmu(som* som, double* ind);
 /* find the cross-modal elicited winner neuron */
 neuron* cln_find_xmodal_bmu(som* soms, som* somt);
@@ -102,5 +124,14 @@ void cln_compute_xmodal_activation(som* s, neuron* bmu);
 void cln_compute_joint_activation(som* s);
 /* adapt the sensory projecton weights */
 void cln_compute_sensory_weights(som* s, double* in_vector);
-/* adapt the cross-modal hebbian links */
+/* adapt the cross-modal hebbian links shared by s and d */
 void cln_compute_xmodal_weights(som* s, som* d);
+/* infer the dst input from a src input through the cross-modal links, leaves the soms untouched
+   scratch holds src and dst lattice sized activations, returns the dst winner index */
+int cln_recall(som* src, som* dst, double* in, double* out, double* scratch);
+/* recall from a given src sensory winner, the rest of cln_recall */
+int cln_recall_winner(som* src, som* dst, int win, double* out, double* scratch);
+/* clear the accumulated convergence metrics */
+void cln_reset_metrics(som* s);
+
+#endif
@@ -12,8 +12,18 @@
         Tools to use in simulating networks dynamics. Implementation.
 */
 
+#include <time.h>
 #include "tools.h"
 
+/* progress messages switch */
+int cln_verbose = 1;
+
+/* turn the progress messages on or off */
+void cln_set_verbose(int on)
+{
+	cln_verbose = on;
+}
+
 /* compute the norm of 2 vectors */
 double cln_compute_norm(double* v1, double* v2, int sz)
 {
@@ -23,3 +33,17 @@ double cln_compute_norm(double* v1, double* v2, int sz)
 	return sqrt(norm);
 }
 
+/* monotonic time in seconds */
+double cln_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+/* ascending order of floats for qsort */
+int cln_cmp_float(const void* a, const void* b)
+{
+	float fa = *(const float*)a, fb = *(const float*)b;
+	return (fa > fb) - (fa < fb);
+}
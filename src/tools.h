@@ -12,8 +12,25 @@
 	Tools to use in simulating networks dynamics. Definition.      
 */
 
+#ifndef CLN_TOOLS_H
+#define CLN_TOOLS_H
+
+#include <stdio.h>
 #include <math.h>
 
+/* progress messages, silenced with cln_set_verbose(0) */
+#define CLN_LOG(...) do{ if(cln_verbose) printf(__VA_ARGS__); }while(0)
+
+/* progress messages switch */
+extern int cln_verbose;
+
+/* turn the progress messages on or off */
+void cln_set_verbose(int on);
 /* compute the norm of 2 vectors */
 double cln_compute_norm(double* v1, double* v2, int sz);
+/* monotonic time in seconds */
+double cln_now(void);
+/* ascending order of floats for qsort */
+int cln_cmp_float(const void* a, const void* b);
 
+#endif
@@ -0,0 +1,158 @@
+/*
+   Unsupervised correlation learning network using self-organizing maps
+
+        Each sensor projects onto a SOM network which will encode
+        the sensory afferent into neural activity. Depending on the
+        global network connectivity (1, 2, 3, ..., N sensory vars)
+        each SOM connects to other SOMs associated with other sensory
+        variables.
+
+        Simple scenario with 2 variables, representing sensory data.
+
+        Training trajectory recorder.
+*/
+
+#include "trajectory.h"
+
+/* size in floats of a som snapshot in a record */
+size_t cln_traj_som_floats(const cln_traj_som* s)
+{
+	size_t nn = s->xsize*s->ysize;
+	return nn*s->insize + 3*nn;
+}
+
+/* background writer - drains the queue to disk */
+static void* cln_recorder_writer(void* arg)
+{
+	cln_recorder* r = (cln_recorder*)arg;
+	pthread_mutex_lock(&r->lock);
+	while(1){
+		while(r->count == 0 && !r->stop)
+			pthread_cond_wait(&r->ready, &r->lock);
+		if(r->count == 0)
+			break;
+		char* rec = r->slots[r->head];
+		pthread_mutex_unlock(&r->lock);
+		/* the slot stays owned by the writer until head moves */
+		fwrite(rec, r->rec_size, 1, r->fout);
+		pthread_mutex_lock(&r->lock);
+		r->head = (r->head + 1) % r->depth;
+		r->count--;
+		r->written++;
+	}
+	pthread_mutex_unlock(&r->lock);
+	return NULL;
+}
+
+/* create a recorder writing every given epochs through a queue of depth snapshots */
+cln_recorder* cln_create_recorder(const char* file, som** soms, int nsoms, int every, int depth)
+{
+	CLN_LOG("cln_create_recorder: Recording training trajectory to %s ...\n", file);
+	/* every snapshot would copy the whole weights file */
+	if(cln_any_mapped_link(soms, nsoms)){
+		printf("cln_create_recorder: Mapped cross-modal weights are not recorded, recording disabled.\n");
+		return NULL;
+	}
+	FILE* fout = fopen(file, "wb");
+	if(!fout){
+		printf("cln_create_recorder: Cannot create trajectory file.\n");
+		return NULL;
+	}
+	cln_recorder* r = (cln_recorder*)calloc(1, sizeof(cln_recorder));
+	r->fout = fout;
+	r->soms = soms;
+	r->nsoms = nsoms;
+	r->every = every;
+	r->depth = depth;
+	r->nlinks = cln_collect_links(soms, nsoms, r->links, CLN_TRAJ_MAX_LINKS);
+	/* file header, soms and links shapes */
+	cln_traj_header hdr = {CLN_TRAJ_MAGIC, CLN_TRAJ_VERSION, nsoms, r->nlinks, every};
+	fwrite(&hdr, sizeof(hdr), 1, fout);
+	r->rec_size = sizeof(cln_traj_record);
+	for(int idx = 0; idx < nsoms; idx++){
+		cln_traj_som ts = {soms[idx]->id, soms[idx]->xsize, soms[idx]->ysize, soms[idx]->insize};
+		fwrite(&ts, sizeof(ts), 1, fout);
+		r->rec_size += cln_traj_som_floats(&ts)*sizeof(float);
+	}
+	for(int idx = 0; idx < r->nlinks; idx++){
+		cln_traj_link tl = {r->links[idx]->s->id, r->links[idx]->d->id, r->links[idx]->ns, r->links[idx]->nd};
+		fwrite(&tl, sizeof(tl), 1, fout);
+		r->rec_size += (size_t)tl.ns*tl.nd*sizeof(float);
+	}
+	/* preallocate the queue so snapshots never allocate */
+	r->slots = (char**)calloc(depth, sizeof(char*));
+	for(int idx = 0; idx < depth; idx++)
+		r->slots[idx] = (char*)calloc(1, r->rec_size);
+	pthread_mutex_init(&r->lock, NULL);
+	pthread_cond_init(&r->ready, NULL);
+	pthread_create(&r->writer, NULL, cln_recorder_writer, r);
+	CLN_LOG("cln_create_recorder: Snapshot every %d epochs, %zu bytes per snapshot.\n", every, r->rec_size);
+	return r;
+}
+
+/* snapshot the soms and the simulation schedule at the given epoch, never blocks on I/O */
+void cln_record_epoch(cln_recorder* r, simopts* so, int epoch)
+{
+	if(epoch % r->every)
+		return;
+	pthread_mutex_lock(&r->lock);
+	if(r->count == r->depth){
+		r->dropped++;
+		pthread_mutex_unlock(&r->lock);
+		return;
+	}
+	/* the free slot after the queued ones is owned by the trainer until published */
+	char* rec = r->slots[(r->head + r->count) % r->depth];
+	pthread_mutex_unlock(&r->lock);
+	cln_traj_record* th = (cln_traj_record*)rec;
+	th->epoch = epoch;
+	th->learn_rule = so->learn_rule;
+	th->alpha = so->alpha[so->cur_epoch];
+	th->sigma = so->sigma[so->cur_epoch];
+	th->gamma = so->gamma[so->cur_epoch];
+	th->xi = so->xi[so->cur_epoch];
+	th->kappa = so->kappa[so->cur_epoch];
+	float* out = (float*)(rec + sizeof(cln_traj_record));
+	for(int sidx = 0; sidx < r->nsoms; sidx++){
+		som* s = r->soms[sidx];
+		int nn = s->xsize*s->ysize;
+		const neuron* n = s->neurons[0];
+		const double* W = n[0].W;
+		for(int idx = 0; idx < nn*s->insize; idx++)
+			*out++ = (float)W[idx];
+		for(int idx = 0; idx < nn; idx++)
+			*out++ = (float)n[idx].As;
+		for(int idx = 0; idx < nn; idx++)
+			*out++ = (float)n[idx].Ax;
+		for(int idx = 0; idx < nn; idx++)
+			*out++ = (float)n[idx].At;
+	}
+	for(int lidx = 0; lidx < r->nlinks; lidx++){
+		const cln_link* l = r->links[lidx];
+		for(size_t idx = 0; idx < (size_t)l->ns*l->nd; idx++)
+			*out++ = (float)l->H[idx];
+	}
+	/* hand the snapshot to the writer */
+	pthread_mutex_lock(&r->lock);
+	r->count++;
+	pthread_cond_signal(&r->ready);
+	pthread_mutex_unlock(&r->lock);
+}
+
+/* flush queued snapshots, stop the writer and close the trajectory file */
+void cln_destroy_recorder(cln_recorder* r)
+{
+	pthread_mutex_lock(&r->lock);
+	r->stop = 1;
+	pthread_cond_signal(&r->ready);
+	pthread_mutex_unlock(&r->lock);
+	pthread_join(r->writer, NULL);
+	fclose(r->fout);
+	CLN_LOG("cln_destroy_recorder: Wrote %ld snapshots, dropped %ld.\n", r->written, r->dropped);
+	for(int idx = 0; idx < r->depth; idx++)
+		free(r->slots[idx]);
+	free(r->slots);
+	pthread_mutex_destroy(&r->lock);
+	pthread_cond_destroy(&r->ready);
+	free(r);
+}
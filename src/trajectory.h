@@ -0,0 +1,103 @@
+/*
+   Unsupervised correlation learning network using self-organizing maps
+
+        Each sensor projects onto a SOM network which will encode
+        the sensory afferent into neural activity. Depending on the
+        global network connectivity (1, 2, 3, ..., N sensory vars)
+        each SOM connects to other SOMs associated with other sensory
+        variables.
+
+        Simple scenario with 2 variables, representing sensory data.
+
+        Training trajectory recorder.
+
+        Snapshots of the soms are taken on the training thread into
+        preallocated slots of a bounded queue and written to disk by a
+        background thread. If the writer falls behind, snapshots are
+        dropped (and counted) instead of stalling training.
+
+        File layout: cln_traj_header, nsoms x cln_traj_som, nlinks x
+        cln_traj_link, then one record per snapshot: cln_traj_record
+        followed, for each som, by the float arrays W (nn*insize), As, Ax,
+        At (nn each), nn = xsize*ysize, and for each link by its cross-modal
+        weights H (ns*nd, row major, s som on the rows).
+        Use the cln_traj2txt tool to convert a trajectory to text.
+*/
+
+#ifndef CLN_TRAJECTORY_H
+#define CLN_TRAJECTORY_H
+
+#include <pthread.h>
+#include "link.h"
+
+#define CLN_TRAJ_MAGIC		0x434c4e54U	// "CLNT"
+#define CLN_TRAJ_VERSION	1
+#define CLN_TRAJ_MAX_LINKS	8	// max number of recorded links
+
+/* trajectory file header */
+typedef struct{
+	unsigned int magic;	// file tag
+	int version;		// format version
+	int nsoms;		// number of recorded soms
+	int nlinks;		// number of recorded links
+	int every;		// epochs between snapshots
+}cln_traj_header;
+
+/* recorded som shape */
+typedef struct{
+	short id;		// id of the network
+	short xsize;		// size of the network x dimension
+	short ysize;		// size of the network y dimension
+	short insize;		// input vector size
+}cln_traj_som;
+
+/* recorded link shape */
+typedef struct{
+	short s_id;		// id of the som on the rows
+	short d_id;		// id of the som on the columns
+	int ns;			// number of rows
+	int nd;			// number of columns
+}cln_traj_link;
+
+/* snapshot record header */
+typedef struct{
+	int epoch;		// training epoch of the snapshot
+	short learn_rule;	// cross-modal learning rule
+	double alpha;		// sensory projections learning rate
+	double sigma;		// neighborhood size
+	double gamma;		// cross-modal impact factor
+	double xi;		// inhibitory component factor
+	double kappa;		// cross-modal Hebbian learning rate
+}cln_traj_record;
+
+/* trajectory recorder */
+typedef struct{
+	FILE* fout;		// trajectory file
+	som** soms;		// recorded soms
+	int nsoms;		// number of recorded soms
+	cln_link* links[CLN_TRAJ_MAX_LINKS];	// recorded links
+	int nlinks;		// number of recorded links
+	int every;		// epochs between snapshots
+	size_t rec_size;	// bytes per snapshot record
+	char** slots;		// preallocated snapshot records
+	int depth;		// number of slots in the queue
+	int head;		// oldest queued snapshot
+	int count;		// queued snapshots
+	int stop;		// writer shutdown request
+	long written;		// snapshots written to disk
+	long dropped;		// snapshots dropped on a full queue
+	pthread_mutex_t lock;	// queue lock
+	pthread_cond_t ready;	// signals queued snapshots to the writer
+	pthread_t writer;	// background writer thread
+}cln_recorder;
+
+/* size in floats of a som snapshot in a record */
+size_t cln_traj_som_floats(const cln_traj_som* s);
+/* create a recorder writing every given epochs through a queue of depth snapshots */
+cln_recorder* cln_create_recorder(const char* file, som** soms, int nsoms, int every, int depth);
+/* snapshot the soms and the simulation schedule at the given epoch, never blocks on I/O */
+void cln_record_epoch(cln_recorder* r, simopts* so, int epoch);
+/* flush queued snapshots, stop the writer and close the trajectory file */
+void cln_destroy_recorder(cln_recorder* r);
+
+#endif
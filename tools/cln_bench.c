@@ -0,0 +1,107 @@
+/*
+   Unsupervised correlation learning network using self-organizing maps
+
+        Each sensor projects onto a SOM network which will encode
+        the sensory afferent into neural activity. Depending on the
+        global network connectivity (1, 2, 3, ..., N sensory vars)
+        each SOM connects to other SOMs associated with other sensory
+        variables.
+
+        Simple scenario with 2 variables, representing sensory data.
+
+        Latency benchmark of the embeddable learner.
+
+        A real-time learner is trained on artificial co-occurring inputs
+        generated up front, then recalls in both directions. Every step
+        and recall is timed and the distribution is reported, worst case
+        included. The benchmark runs under SCHED_FIFO when it is allowed
+        to.
+
+        usage: cln_bench [steps] [som x size] [som y size]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include "cln.h"
+#include "tools.h"
+
+#define CLN_BENCH_STEPS		100000	// default timed steps
+#define CLN_BENCH_WARMUP	1000	// untimed steps to settle caches and branch predictors
+#define CLN_BENCH_INSIZE	2	// input vector size
+
+/* print the latency distribution of n timed calls (us) */
+static void cln_report_latency(const char* what, float* lat, long n)
+{
+	double sum = 0.0f;
+	for(long idx = 0; idx < n; idx++)
+		sum += lat[idx];
+	qsort(lat, n, sizeof(float), cln_cmp_float);
+	printf("cln_bench: %-10s mean %8.3f us  p50 %8.3f us  p99 %8.3f us  p99.9 %8.3f us  max %8.3f us\n",
+	       what, sum/n, lat[n/2], lat[(long)(n*0.99)], lat[(long)(n*0.999)], lat[n - 1]);
+}
+
+/* entry point */
+int main(int argc, char** argv)
+{
+	long steps = argc > 1 ? atol(argv[1]) : CLN_BENCH_STEPS;
+	short xsize = argc > 2 ? atoi(argv[2]) : 10;
+	short ysize = argc > 3 ? atoi(argv[3]) : 10;
+	if(steps <= 0 || xsize <= 0 || ysize <= 0){
+		printf("usage: %s [steps] [som x size] [som y size]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	cln_set_verbose(0);
+	cln_config cfg = {
+		{xsize, xsize}, {ysize, ysize}, {CLN_BENCH_INSIZE, CLN_BENCH_INSIZE}, {2, 8}, {12, 48},
+		CLN_PARAMS_ADAPTIVE, CLN_RULE_HEBBIAN, 0.1f, (xsize > ysize ? xsize : ysize)/2.0f, 0.1f, 0.01f, 0.3f, 500,
+		100, 1000, CLN_REALTIME
+	};
+	/* same artificial correlation as the training demo, generated before timing */
+	long total = steps + CLN_BENCH_WARMUP;
+	double* in = (double*)calloc(total*2*CLN_BENCH_INSIZE, sizeof(double));
+	for(long idx = 0; idx < total*2*CLN_BENCH_INSIZE; idx++)
+		in[idx] = 4.5f*(1 + (idx/CLN_BENCH_INSIZE)%2) + 1.0f + (double)rand()/(double)RAND_MAX;
+	float* lat_step = (float*)malloc(steps*sizeof(float));
+	float* lat_recall = (float*)malloc(steps*sizeof(float));
+	double out[CLN_BENCH_INSIZE];
+	struct rusage ru0, ru1;
+	/* fault the result buffers in before timing */
+	mlock(lat_step, steps*sizeof(float));
+	mlock(lat_recall, steps*sizeof(float));
+	struct sched_param sp = {sched_get_priority_max(SCHED_FIFO)};
+	int fifo = sched_setscheduler(0, SCHED_FIFO, &sp) == 0;
+	cln_net* net = cln_net_create(&cfg);
+	if(!net)
+		return EXIT_FAILURE;
+	printf("cln_bench: %dx%d soms, %ld steps, memory locked, %s scheduling\n", xsize, ysize, steps, fifo ? "SCHED_FIFO" : "default");
+	for(long idx = 0; idx < total; idx++){
+		double* in1 = &in[idx*2*CLN_BENCH_INSIZE];
+		double* in2 = in1 + CLN_BENCH_INSIZE;
+		if(idx == CLN_BENCH_WARMUP)
+			getrusage(RUSAGE_SELF, &ru0);
+		double t0 = cln_now();
+		cln_net_train_step(net, in1, in2);
+		double t1 = cln_now();
+		if(idx >= CLN_BENCH_WARMUP)
+			lat_step[idx - CLN_BENCH_WARMUP] = (float)((t1 - t0)*1e6);
+	}
+	for(long idx = 0; idx < steps; idx++){
+		double* in1 = &in[(idx + CLN_BENCH_WARMUP)*2*CLN_BENCH_INSIZE];
+		double t0 = cln_now();
+		cln_net_recall(net, idx%2, in1 + (idx%2)*CLN_BENCH_INSIZE, out);
+		lat_recall[idx] = (float)((cln_now() - t0)*1e6);
+	}
+	getrusage(RUSAGE_SELF, &ru1);
+	printf("cln_bench: page faults while timing minor %ld major %ld, context switches involuntary %ld\n",
+	       ru1.ru_minflt - ru0.ru_minflt, ru1.ru_majflt - ru0.ru_majflt, ru1.ru_nivcsw - ru0.ru_nivcsw);
+	cln_report_latency("train step", lat_step, steps);
+	cln_report_latency("recall", lat_recall, steps);
+	cln_net_destroy(net);
+	free(in);
+	free(lat_step);
+	free(lat_recall);
+	return EXIT_SUCCESS;
+}
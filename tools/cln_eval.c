@@ -0,0 +1,258 @@
+/*
+   Unsupervised correlation learning network using self-organizing maps
+
+        Each sensor projects onto a SOM network which will encode
+        the sensory afferent into neural activity. Depending on the
+        global network connectivity (1, 2, 3, ..., N sensory vars)
+        each SOM connects to other SOMs associated with other sensory
+        variables.
+
+        Simple scenario with 2 variables, representing sensory data.
+
+        Offline evaluator of a trained model on a held-out sensor log.
+
+        The held-out samples are split across all online cores. Each
+        worker measures, for both soms, the quantization and topographic
+        errors and, for both directions, the cross-modal inference error
+        (distance from the recalled to the held-out vector) and the recall
+        latency of every sample. The report is written as JSON so runs can
+        be compared between builds and parameter sets.
+
+        usage: cln_eval <model file> <held-out sensor log> <som1 column> <som2 column> [report file]
+*/
+
+#include "model.h"
+#include "pipeline.h"
+
+#define CLN_EVAL_CHUNK		4096			// samples parsed per source fill
+#define CLN_EVAL_REPORT		"cln_eval_report.json"	// default report file
+
+/* held-out samples */
+typedef struct{
+	long len;		// number of samples
+	int vsize;		// input vector size
+	double* data[2];	// samples of each som, flat (len*vsize)
+}cln_eval_set;
+
+/* evaluation share of a worker */
+typedef struct{
+	cln_model* m;		// evaluated model
+	cln_eval_set* set;	// held-out samples
+	long from;		// first sample
+	long to;		// past the last sample
+	float* lat[2];		// recall latency of each sample and direction (us)
+	double qe[2];		// summed quantization error of each som
+	long te[2];		// topographic errors of each som
+	double xerr[2];		// summed cross-modal error of each direction
+	double xerr2[2];	// summed squared cross-modal error of each direction
+	double xmax[2];		// max cross-modal error of each direction
+	pthread_t tid;		// worker thread
+}cln_eval_job;
+
+/* write a string as a JSON string literal */
+static void cln_json_string(FILE* fout, const char* str)
+{
+	fputc('"', fout);
+	for(const unsigned char* c = (const unsigned char*)str; *c; c++){
+		if(*c == '"' || *c == '\\')
+			fprintf(fout, "\\%c", *c);
+		else if(*c < 0x20)
+			fprintf(fout, "\\u%04x", *c);
+		else
+			fputc(*c, fout);
+	}
+	fputc('"', fout);
+}
+
+/* read the whole held-out log into memory */
+static int cln_load_set(cln_eval_set* set, char* file, int* cols, int vsize)
+{
+	cln_source src = cln_sensor_file_source(file, cols, 2);
+	if(!src.ctx)
+		return -1;
+	long cap = CLN_EVAL_CHUNK;
+	double* chunk[2];
+	memset(set, 0, sizeof(cln_eval_set));
+	set->vsize = vsize;
+	for(int sidx = 0; sidx < 2; sidx++){
+		set->data[sidx] = (double*)calloc(cap*vsize, sizeof(double));
+		chunk[sidx] = (double*)calloc(CLN_EVAL_CHUNK*vsize, sizeof(double));
+	}
+	for(int n; (n = src.fill(src.ctx, chunk, 2, vsize, CLN_EVAL_CHUNK)) > 0; set->len += n){
+		if(set->len + n > cap){
+			cap *= 2;
+			for(int sidx = 0; sidx < 2; sidx++)
+				set->data[sidx] = (double*)realloc(set->data[sidx], cap*vsize*sizeof(double));
+		}
+		for(int sidx = 0; sidx < 2; sidx++)
+			memcpy(&set->data[sidx][set->len*vsize], chunk[sidx], n*vsize*sizeof(double));
+	}
+	src.close(src.ctx);
+	free(chunk[0]);
+	free(chunk[1]);
+	return set->len > 0 ? EXIT_SUCCESS : -1;
+}
+
+/* best and second best matching neurons, same metric as the training search, returns the best distance */
+static double cln_eval_winners(const som* s, double* in, int* win, int* second)
+{
+	const neuron* n = s->neurons[0];
+	double min_qe = DBL_MAX, second_qe = DBL_MAX;
+	*win = *second = 0;
+	for(int idx = 0; idx < s->xsize*s->ysize; idx++){
+		double qe = cln_compute_norm(in, n[idx].W, s->insize);
+		if(qe < min_qe){
+			second_qe = min_qe;
+			*second = *win;
+			min_qe = qe;
+			*win = idx;
+		}
+		else if(qe < second_qe){
+			second_qe = qe;
+			*second = idx;
+		}
+	}
+	return min_qe;
+}
+
+/* evaluate a share of the held-out samples */
+static void* cln_eval_worker(void* arg)
+{
+	cln_eval_job* job = (cln_eval_job*)arg;
+	som* soms[2] = {job->m->s, job->m->d};
+	int vsize = job->set->vsize;
+	double* scratch = (double*)calloc(job->m->link->ns + job->m->link->nd, sizeof(double));
+	double* out = (double*)calloc(vsize, sizeof(double));
+	/* sums stay private until the end, neighbouring jobs share cache lines */
+	double qe[2] = {0}, xerr[2] = {0}, xerr2[2] = {0}, xmax[2] = {0};
+	long te[2] = {0};
+	for(long idx = job->from; idx < job->to; idx++){
+		for(int dir = 0; dir < 2; dir++){
+			som* src = soms[dir];
+			som* dst = soms[1 - dir];
+			double* in = &job->set->data[dir][idx*vsize];
+			double* target = &job->set->data[1 - dir][idx*vsize];
+			int win, second;
+			/* maps quality on the som own input */
+			qe[dir] += cln_eval_winners(src, in, &win, &second);
+			te[dir] += abs(win/src->ysize - second/src->ysize) > 1 || abs(win%src->ysize - second%src->ysize) > 1;
+			/* cross-modal inference of the other input */
+			double t0 = cln_now();
+			cln_recall(src, dst, in, out, scratch);
+			job->lat[dir][idx] = (float)((cln_now() - t0)*1e6);
+			double err = 0.0f;
+			for(int widx = 0; widx < vsize; widx++)
+				err += (out[widx] - target[widx])*(out[widx] - target[widx]);
+			xerr2[dir] += err;
+			err = sqrt(err);
+			xerr[dir] += err;
+			xmax[dir] = MAX(xmax[dir], err);
+		}
+	}
+	for(int dir = 0; dir < 2; dir++){
+		job->qe[dir] = qe[dir];
+		job->te[dir] = te[dir];
+		job->xerr[dir] = xerr[dir];
+		job->xerr2[dir] = xerr2[dir];
+		job->xmax[dir] = xmax[dir];
+	}
+	free(scratch);
+	free(out);
+	return NULL;
+}
+
+/* entry point */
+int main(int argc, char** argv)
+{
+	cln_eval_set set;
+	if(argc < 5){
+		printf("usage: %s <model file> <held-out sensor log> <som1 column> <som2 column> [report file]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	char* report = argc > 5 ? argv[5] : CLN_EVAL_REPORT;
+	int cols[2] = {atoi(argv[3]), atoi(argv[4])};
+	cln_model* m = cln_load_model(argv[1]);
+	if(!m)
+		return EXIT_FAILURE;
+	if(m->s->insize != m->d->insize){
+		printf("cln_eval: Soms with different input sizes are not supported !\n");
+		return EXIT_FAILURE;
+	}
+	double t0 = cln_now();
+	if(cln_load_set(&set, argv[2], cols, m->s->insize) < 0){
+		printf("cln_eval: No held-out samples in %s !\n", argv[2]);
+		return EXIT_FAILURE;
+	}
+	double t1 = cln_now();
+	/* split the samples across all cores */
+	long nthreads = MAX(1, MIN(sysconf(_SC_NPROCESSORS_ONLN), set.len));
+	cln_eval_job* jobs = (cln_eval_job*)calloc(nthreads, sizeof(cln_eval_job));
+	float* lat[2] = {(float*)calloc(set.len, sizeof(float)), (float*)calloc(set.len, sizeof(float))};
+	for(long tidx = 0; tidx < nthreads; tidx++){
+		jobs[tidx].m = m;
+		jobs[tidx].set = &set;
+		jobs[tidx].from = set.len*tidx/nthreads;
+		jobs[tidx].to = set.len*(tidx + 1)/nthreads;
+		jobs[tidx].lat[0] = lat[0];
+		jobs[tidx].lat[1] = lat[1];
+		pthread_create(&jobs[tidx].tid, NULL, cln_eval_worker, &jobs[tidx]);
+	}
+	double qe[2] = {0}, xerr[2] = {0}, xerr2[2] = {0}, xmax[2] = {0};
+	long te[2] = {0};
+	for(long tidx = 0; tidx < nthreads; tidx++){
+		pthread_join(jobs[tidx].tid, NULL);
+		for(int dir = 0; dir < 2; dir++){
+			qe[dir] += jobs[tidx].qe[dir];
+			te[dir] += jobs[tidx].te[dir];
+			xerr[dir] += jobs[tidx].xerr[dir];
+			xerr2[dir] += jobs[tidx].xerr2[dir];
+			xmax[dir] = MAX(xmax[dir], jobs[tidx].xmax[dir]);
+		}
+	}
+	double t2 = cln_now();
+	FILE* fout = fopen(report, "w");
+	if(!fout){
+		printf("cln_eval: Cannot create report file %s !\n", report);
+		return EXIT_FAILURE;
+	}
+	som* soms[2] = {m->s, m->d};
+	fprintf(fout, "{\n");
+	fprintf(fout, "  \"model\": ");
+	cln_json_string(fout, argv[1]);
+	fprintf(fout, ",\n  \"dataset\": ");
+	cln_json_string(fout, argv[2]);
+	fprintf(fout, ",\n  \"columns\": [%d, %d],\n", cols[0], cols[1]);
+	fprintf(fout, "  \"samples\": %ld,\n  \"threads\": %ld,\n", set.len, nthreads);
+	fprintf(fout, "  \"load_s\": %.6lf,\n  \"eval_s\": %.6lf,\n  \"samples_per_s\": %.1lf,\n", t1 - t0, t2 - t1, set.len/(t2 - t1));
+	fprintf(fout, "  \"soms\": [\n");
+	for(int dir = 0; dir < 2; dir++){
+		fprintf(fout, "    {\"id\": %d, \"xsize\": %d, \"ysize\": %d, \"insize\": %d, \"qe\": %.9lf, \"te\": %.9lf}%s\n",
+			soms[dir]->id, soms[dir]->xsize, soms[dir]->ysize, soms[dir]->insize,
+			qe[dir]/set.len, (double)te[dir]/set.len, dir ? "" : ",");
+	}
+	fprintf(fout, "  ],\n  \"xmodal\": [\n");
+	for(int dir = 0; dir < 2; dir++){
+		/* latency percentiles over all samples */
+		double lsum = 0.0f;
+		for(long idx = 0; idx < set.len; idx++)
+			lsum += lat[dir][idx];
+		qsort(lat[dir], set.len, sizeof(float), cln_cmp_float);
+		fprintf(fout, "    {\"from\": %d, \"to\": %d, \"mean_err\": %.9lf, \"rmse\": %.9lf, \"max_err\": %.9lf,\n",
+			soms[dir]->id, soms[1 - dir]->id, xerr[dir]/set.len, sqrt(xerr2[dir]/set.len), xmax[dir]);
+		fprintf(fout, "     \"latency_us\": {\"mean\": %.3lf, \"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f}}%s\n",
+			lsum/set.len, lat[dir][set.len/2], lat[dir][(long)(set.len*0.99)], lat[dir][set.len - 1], dir ? "" : ",");
+		printf("cln_eval: SOM%d->SOM%d qe %lf te %lf xmodal error mean %lf max %lf, recall p50 %.3f us p99 %.3f us\n",
+		       soms[dir]->id, soms[1 - dir]->id, qe[dir]/set.len, (double)te[dir]/set.len, xerr[dir]/set.len, xmax[dir],
+		       lat[dir][set.len/2], lat[dir][(long)(set.len*0.99)]);
+	}
+	fprintf(fout, "  ]\n}\n");
+	fclose(fout);
+	printf("cln_eval: Evaluated %ld samples on %ld threads in %.3lf s, report in %s.\n", set.len, nthreads, t2 - t1, report);
+	free(lat[0]);
+	free(lat[1]);
+	free(jobs);
+	free(set.data[0]);
+	free(set.data[1]);
+	cln_destroy_model(m);
+	return EXIT_SUCCESS;
+}
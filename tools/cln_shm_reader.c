@@ -0,0 +1,87 @@
+/*
+   Unsupervised correlation learning network using self-organizing maps
+
+        Each sensor projects onto a SOM network which will encode
+        the sensory afferent into neural activity. Depending on the
+        global network connectivity (1, 2, 3, ..., N sensory vars)
+        each SOM connects to other SOMs associated with other sensory
+        variables.
+
+        Simple scenario with 2 variables, representing sensory data.
+
+        Reader of a model published in shared memory by the trainer.
+
+        Repeatedly takes a view of the latest model, sums all its weights
+        and validates the view afterwards, retrying reads the trainer
+        overwrote meanwhile. Each new model is reported with its epoch and
+        checksum, so a run next to the trainer shows the readers never wait
+        for it and never keep a torn model.
+
+        usage: cln_shm_reader [shared model name] [reads]
+*/
+
+#include "publish.h"
+
+#define CLN_READER_NAME		"/cln_model"	// default shared memory object
+#define CLN_READER_READS	100000		// default number of reads
+#define CLN_READER_IDLE_US	100		// pause between reads (us)
+
+/* sum the weights of a model view */
+static double cln_view_checksum(const cln_shm_header* hdr, const cln_shm_view* v)
+{
+	double sum = 0.0f;
+	for(int idx = 0; idx < hdr->nsoms; idx++){
+		size_t len = (size_t)hdr->soms[idx].xsize*hdr->soms[idx].ysize*hdr->soms[idx].insize;
+		for(size_t widx = 0; widx < len; widx++)
+			sum += v->W[idx][widx];
+	}
+	for(int idx = 0; idx < hdr->nlinks; idx++){
+		size_t len = (size_t)hdr->links[idx].ns*hdr->links[idx].nd;
+		for(size_t hidx = 0; hidx < len; hidx++)
+			sum += v->H[idx][hidx];
+	}
+	return sum;
+}
+
+/* entry point */
+int main(int argc, char** argv)
+{
+	char* name = argc > 1 ? argv[1] : CLN_READER_NAME;
+	long reads = argc > 2 ? atol(argv[2]) : CLN_READER_READS;
+	if(reads <= 0){
+		printf("usage: %s [shared model name] [reads]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	cln_subscriber* sub = cln_open_subscriber(name);
+	if(!sub)
+		return EXIT_FAILURE;
+	printf("cln_shm_reader: %s holds %d soms and %d links.\n", name, sub->hdr->nsoms, sub->hdr->nlinks);
+	long empty = 0, torn = 0, models = 0;
+	int last_epoch = -1;
+	for(long ridx = 0; ridx < reads; ridx++){
+		cln_shm_view v;
+		unsigned long seq = cln_read_begin(sub, &v);
+		if(!seq){
+			/* nothing published yet */
+			empty++;
+			usleep(CLN_READER_IDLE_US);
+			continue;
+		}
+		double sum = cln_view_checksum(sub->hdr, &v);
+		if(!cln_read_validate(sub, seq)){
+			/* the trainer reused the slot while summing, drop the view */
+			torn++;
+			continue;
+		}
+		if(v.epoch != last_epoch){
+			printf("cln_shm_reader: Model of epoch %d, seq %lu, checksum %lf\n", v.epoch, seq, sum);
+			last_epoch = v.epoch;
+			models++;
+		}
+		usleep(CLN_READER_IDLE_US);
+	}
+	printf("cln_shm_reader: %ld reads, %ld models seen, %ld before the first model, %ld overwritten and retried.\n",
+	       reads, models, empty, torn);
+	cln_close_subscriber(sub);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+/*
+   Unsupervised correlation learning network using self-organizing maps
+
+        Each sensor projects onto a SOM network which will encode
+        the sensory afferent into neural activity. Depending on the
+        global network connectivity (1, 2, 3, ..., N sensory vars)
+        each SOM connects to other SOMs associated with other sensory
+        variables.
+
+        Simple scenario with 2 variables, representing sensory data.
+
+        Offline converter of a recorded training trajectory to text.
+
+        usage: cln_traj2txt <trajectory file> [text file]
+*/
+
+#include "trajectory.h"
+
+/* print a lattice shaped float matrix */
+static void cln_print_lattice(FILE* fout, const float* v, int rows, int cols)
+{
+	for(int idx = 0; idx < rows; idx++){
+		for(int jdx = 0; jdx < cols; jdx++)
+			fprintf(fout, " %f ", v[idx*cols + jdx]);
+		fprintf(fout, "\n");
+	}
+}
+
+/* entry point */
+int main(int argc, char** argv)
+{
+	cln_traj_header hdr;
+	if(argc < 2){
+		printf("usage: %s <trajectory file> [text file]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	FILE* fin = fopen(argv[1], "rb");
+	FILE* fout = argc > 2 ? fopen(argv[2], "w") : stdout;
+	if(!fin || !fout){
+		printf("cln_traj2txt: Cannot open trajectory or text file !\n");
+		return EXIT_FAILURE;
+	}
+	if(fread(&hdr, sizeof(hdr), 1, fin) != 1 || hdr.magic != CLN_TRAJ_MAGIC || hdr.version != CLN_TRAJ_VERSION){
+		printf("cln_traj2txt: %s is not a trajectory file !\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	cln_traj_som* soms = (cln_traj_som*)calloc(hdr.nsoms, sizeof(cln_traj_som));
+	if(fread(soms, sizeof(cln_traj_som), hdr.nsoms, fin) != (size_t)hdr.nsoms){
+		printf("cln_traj2txt: Truncated trajectory header !\n");
+		return EXIT_FAILURE;
+	}
+	cln_traj_link* links = (cln_traj_link*)calloc(hdr.nlinks, sizeof(cln_traj_link));
+	if(fread(links, sizeof(cln_traj_link), hdr.nlinks, fin) != (size_t)hdr.nlinks){
+		printf("cln_traj2txt: Truncated trajectory header !\n");
+		return EXIT_FAILURE;
+	}
+	size_t nfloats = 0;
+	fprintf(fout, "---- TRAJECTORY: %d SOMS, %d LINKS, SNAPSHOT EVERY %d EPOCHS ----\n", hdr.nsoms, hdr.nlinks, hdr.every);
+	for(int idx = 0; idx < hdr.nsoms; idx++){
+		fprintf(fout, "SOM%d SIZE: %dx%d INSIZE: %d\n", soms[idx].id, soms[idx].xsize, soms[idx].ysize, soms[idx].insize);
+		nfloats += cln_traj_som_floats(&soms[idx]);
+	}
+	for(int idx = 0; idx < hdr.nlinks; idx++){
+		fprintf(fout, "LINK SOM%d-SOM%d SIZE: %dx%d\n", links[idx].s_id, links[idx].d_id, links[idx].ns, links[idx].nd);
+		nfloats += (size_t)links[idx].ns*links[idx].nd;
+	}
+	float* data = (float*)calloc(nfloats, sizeof(float));
+	cln_traj_record rec;
+	long nrec = 0;
+	/* one record per snapshot */
+	while(fread(&rec, sizeof(rec), 1, fin) == 1 && fread(data, sizeof(float), nfloats, fin) == nfloats){
+		fprintf(fout, "\n==== EPOCH %d ====\n", rec.epoch);
+		fprintf(fout, "learn_rule: %d \n alpha: %lf \n sigma: %lf \n gamma: %lf \n xi: %lf \n kappa: %lf \n",
+			rec.learn_rule, rec.alpha, rec.sigma, rec.gamma, rec.xi, rec.kappa);
+		const float* v = data;
+		for(int sidx = 0; sidx < hdr.nsoms; sidx++){
+			int nn = soms[sidx].xsize*soms[sidx].ysize;
+			fprintf(fout, "\nSOM%d SYNAPTIC WEIGHTS - SENSORY AFFERENTS\n", soms[sidx].id);
+			cln_print_lattice(fout, v, nn, soms[sidx].insize);
+			v += nn*soms[sidx].insize;
+			fprintf(fout, "\nSOM%d SENSORY EVOKED NEURAL ACTIVATION\n", soms[sidx].id);
+			cln_print_lattice(fout, v, soms[sidx].xsize, soms[sidx].ysize);
+			v += nn;
+			fprintf(fout, "\nSOM%d CROSS SENSORY EVOKED NEURAL ACTIVATION\n", soms[sidx].id);
+			cln_print_lattice(fout, v, soms[sidx].xsize, soms[sidx].ysize);
+			v += nn;
+			fprintf(fout, "\nSOM%d TOTAL NEURAL ACTIVATION\n", soms[sidx].id);
+			cln_print_lattice(fout, v, soms[sidx].xsize, soms[sidx].ysize);
+			v += nn;
+		}
+		for(int lidx = 0; lidx < hdr.nlinks; lidx++){
+			fprintf(fout, "\nSOM%d-SOM%d SYNAPTIC WEIGHTS - CROSS MODAL LINKS\n", links[lidx].s_id, links[lidx].d_id);
+			cln_print_lattice(fout, v, links[lidx].ns, links[lidx].nd);
+			v += (size_t)links[lidx].ns*links[lidx].nd;
+		}
+		nrec++;
+	}
+	printf("cln_traj2txt: Converted %ld snapshots.\n", nrec);
+	fclose(fin);
+	if(fout != stdout)
+		fclose(fout);
+	free(data);
+	free(soms);
+	free(links);
+	return EXIT_SUCCESS;
+}